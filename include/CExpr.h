@@ -5,35 +5,6 @@
 #include <CStrUtil.h>
 #include <cassert>
 
-class CExprValueBase {
- public:
-  virtual ~CExprValueBase() { }
-
-  virtual CExprValueBase *dup() const { return nullptr; }
-
-  virtual bool getBooleanValue(bool        &) const { return false; }
-  virtual bool getIntegerValue(long        &) const { return false; }
-  virtual bool getRealValue   (double      &) const { return false; }
-  virtual bool getStringValue (std::string &) const { return false; }
-
-  virtual void setBooleanValue(bool               ) { assert(false); }
-  virtual void setIntegerValue(long               ) { assert(false); }
-  virtual void setRealValue   (double             ) { assert(false); }
-  virtual void setStringValue (const std::string &) { assert(false); }
-
-  virtual CExprValuePtr execUnaryOp(CExpr *, CExprOpType) const {
-    return CExprValuePtr();
-  }
-
-  virtual CExprValuePtr execBinaryOp(CExpr *, CExprValuePtr, CExprOpType) const {
-    return CExprValuePtr();
-  }
-
-  virtual void print(std::ostream &os) const {
-    os << "<null>";
-  }
-};
-
 //-------
 
 #include <CExprBValue.h>
@@ -41,11 +12,17 @@ class CExprValueBase {
 #include <CExprRValue.h>
 #include <CExprSValue.h>
 #include <CExprValue.h>
+#include <CExprValuePool.h>
 #include <CExprOperator.h>
 #include <CExprToken.h>
 #include <CExprParse.h>
 #include <CExprVariable.h>
 #include <CExprInterp.h>
+#include <CExprProgram.h>
+#include <CExprRegisterCode.h>
+#include <CExprPeephole.h>
+#include <CExprCompiledExpr.h>
+#include <CExprProgramCache.h>
 #include <CExprCompile.h>
 #include <CExprFunction.h>
 #include <CExprExecute.h>
@@ -64,6 +41,10 @@ class CExpr {
   using Functions   = std::vector<CExprFunctionPtr>;
   using StringArray = std::vector<std::string>;
 
+  // range of integers returned as shared constant values
+  static const long minConstInteger = -128;
+  static const long maxConstInteger = 1023;
+
  public:
   static CExpr *instance();
 
@@ -83,6 +64,14 @@ class CExpr {
   bool getDegrees() const { return degrees_; }
   void setDegrees(bool b) { degrees_ = b; }
 
+  // execute compiled programs using register form (if supported)
+  bool getRegisterVM() const { return registerVM_; }
+  void setRegisterVM(bool b) { registerVM_ = b; }
+
+  // max instructions of user function body inlined at call (0 for no inlining)
+  uint getMaxInlineSize() const { return maxInlineSize_; }
+  void setMaxInlineSize(uint n) { maxInlineSize_ = n; }
+
   bool evaluateExpression(const std::string &str, CExprValueArray &values);
   bool evaluateExpression(const std::string &str, CExprValuePtr &value);
 
@@ -91,12 +80,18 @@ class CExpr {
 
   CExprTokenStack parseLine(const std::string &line);
   CExprITokenPtr  interpPTokenStack(const CExprTokenStack &stack);
-  CExprTokenStack compileIToken(CExprITokenPtr itoken);
+  CExprProgram    compileIToken(CExprITokenPtr itoken);
+
+  // compile user function body (args are local so aren't replaced by constants)
+  CExprProgram    compileIToken(CExprITokenPtr itoken, const StringArray &args);
+
+  // compile expression for repeated evaluation (null if invalid)
+  CExprCompiledExprP compile(const std::string &str);
 
   bool skipExpression(const std::string &line, uint &i);
 
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values);
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value);
+  bool executeProgram(const CExprProgram &program, CExprValueArray &values);
+  bool executeProgram(const CExprProgram &program, CExprValuePtr &value);
 
   void saveCompileState();
   void restoreCompileState();
@@ -112,20 +107,39 @@ class CExpr {
   CExprVariablePtr createIntegerVariable(const std::string &name, long l);
   CExprVariablePtr createStringVariable (const std::string &name, const std::string &str);
 
+  CExprVariablePtr createConstant(const std::string &name, CExprValuePtr value);
+
+  // variable whose value is read from and assigned to host memory (string variable is
+  // read only). Null pointer removes binding
+  CExprVariablePtr bindRealVariable   (const std::string &name, double *r);
+  CExprVariablePtr bindIntegerVariable(const std::string &name, long *l);
+  CExprVariablePtr bindStringVariable (const std::string &name, const char *s);
+
   CExprVariablePtr createUserVariable(const std::string &name, CExprVariableObj *obj);
 
   CExprFunctionPtr getFunction (const std::string &name);
   void             getFunctions(const std::string &name, Functions &functions);
 
+  // function to call with number of arguments
+  CExprFunctionPtr findFunction(const std::string &name, uint numArgs);
+
   CExprFunctionPtr addFunction(const std::string &name, const StringArray &args,
                                const std::string &proc);
   CExprFunctionPtr addFunction(const std::string &name, const std::string &argsStr,
                                CExprFunctionObj *proc);
 
+  // function calling callable with typed arguments and result e.g.
+  //   addFunction<double(double, long)>("f", f)
+  template<typename T, typename F>
+  CExprFunctionPtr addFunction(const std::string &name, F proc);
+
   void removeFunction(const std::string &name);
 
   void getFunctionNames(StringArray &names) const;
 
+  // changed when functions or constants change (compiled programs are out of date)
+  uint functionGeneration() const;
+
   CExprTokenBaseP getOperator(CExprOpType id);
 
   std::string getOperatorName(CExprOpType type) const;
@@ -135,10 +149,44 @@ class CExpr {
   CExprValuePtr createRealValue   (double r);
   CExprValuePtr createStringValue (const std::string &s);
 
+  // modifiable copy of value (allocated from value pool)
+  CExprValuePtr dupValue(const CExprValue &value);
+
+  const CExprValuePool::Stats &valuePoolStats() const;
+
+  // superinstructions made by peephole optimizer
+  const CExprPeephole::Counts &fusionCounts() const;
+
+  void resetFusionCounts();
+
+  void printFusionCounts(std::ostream &os) const;
+
+  void setValuePoolMaxFree(uint n);
+
+  // cache of compiled expressions used by evaluateExpression (max entries of zero
+  // disables cache, max bytes of zero is no limit)
+  void setProgramCacheCapacity(uint maxEntries, size_t maxBytes=0);
+
+  // cache key is token stream instead of expression text
+  void setProgramCacheNormalize(bool b);
+
+  const CExprProgramCache::Stats &programCacheStats() const;
+
+  void clearProgramCache();
+
   std::string printf(const std::string &fmt, const CExprValueArray &values) const;
 
   void errorMsg(const std::string &msg) const;
 
+ private:
+  void createConstantValues();
+
+  CExprVariablePtr bindVariable(const std::string &name, CExprValueType type, void *data);
+
+  CExprFunctionPtr addTypedFunction(CExprFunction *function);
+
+  CExprValuePtr createConstantValue(const CExprValue &value);
+
  private:
   using CExprCompileP = std::shared_ptr<CExprCompile>;
   using Compiles      = std::vector<CExprCompileP>;
@@ -151,11 +199,17 @@ class CExpr {
   using CExprOperatorMgrP = std::unique_ptr<CExprOperatorMgr>;
   using CExprVariableMgrP = std::unique_ptr<CExprVariableMgr>;
   using CExprFunctionMgrP = std::unique_ptr<CExprFunctionMgr>;
+  using CExprPeepholeP    = std::unique_ptr<CExprPeephole>;
+  using CExprProgramCacheP = std::unique_ptr<CExprProgramCache>;
+
+  using ConstantValues = std::vector<CExprValuePtr>;
 
   bool              quiet_   { false };
   bool              debug_   { false };
   bool              trace_   { false };
   bool              degrees_ { false };
+  bool              registerVM_ { false };
+  uint              maxInlineSize_ { 32 };
   CExprParseP       parse_;
   CExprInterpP      interp_;
   CExprCompileP     compile_;
@@ -165,6 +219,14 @@ class CExpr {
   CExprOperatorMgrP operatorMgr_;
   CExprVariableMgrP variableMgr_;
   CExprFunctionMgrP functionMgr_;
+  CExprPeepholeP    peephole_;
+  CExprProgramCacheP programCache_;
+  CExprValuePool*   valuePool_ { nullptr };
+  CExprValuePtr     falseValue_;
+  CExprValuePtr     trueValue_;
+  ConstantValues    integerValues_;
+  CExprValuePtr     realZeroValue_;
+  CExprValuePtr     realOneValue_;
 };
 
 //------
@@ -229,4 +291,8 @@ class CExprUtil<std::string> {
   static std::string argTypeStr() { return "s"; }
 };
 
+//------
+
+#include <CExprTypedFunction.h>
+
 #endif
@@ -1,31 +1,25 @@
 #ifndef CExprBValue_H
 #define CExprBValue_H
 
-class CExprBooleanValue : public CExprValueBase {
+class CExprBooleanValue {
  public:
   CExprBooleanValue(bool boolean) :
    boolean_(boolean) {
   }
 
-  CExprBooleanValue *dup() const override {
-    return new CExprBooleanValue(boolean_);
-  }
-
-  bool getBooleanValue(bool        &b) const override {
+  bool getBooleanValue(bool        &b) const {
     b = boolean_;                      return true; }
-  bool getIntegerValue(long        &l) const override {
+  bool getIntegerValue(long        &l) const {
     l = (boolean_ ?    1   :     0  ); return true; }
-  bool getRealValue   (double      &r) const override {
+  bool getRealValue   (double      &r) const {
     r = (boolean_ ?    1.0 :     0.0); return true; }
-  bool getStringValue (std::string &s) const override {
+  bool getStringValue (std::string &s) const {
     s = (boolean_ ? "true" : "false"); return true; }
 
-  void setBooleanValue(bool b) override { boolean_ = b; }
-
-  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const override;
-  CExprValuePtr execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const override;
+  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const;
+  CExprValuePtr execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const;
 
-  void print(std::ostream &os) const override {
+  void print(std::ostream &os) const {
     os << (boolean_ ? "true" : "false");
   }
 
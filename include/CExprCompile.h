@@ -2,17 +2,22 @@
 #define CExprCompile_H
 
 #include <CExprToken.h>
+#include <CExprProgram.h>
 
 class CExprCompileImpl;
 
 class CExprCompile {
+ public:
+  using Args = std::vector<std::string>;
+
  public:
   CExprCompile(CExpr *expr);
  ~CExprCompile();
 
   CExpr *expr() const { return expr_; }
 
-  CExprTokenStack compileIToken(CExprITokenPtr itoken);
+  // compile expression (args are local identifiers of user function body)
+  CExprProgram compileIToken(CExprITokenPtr itoken, const Args &args=Args());
 
   bool hasFunction(const std::string &name) const;
 
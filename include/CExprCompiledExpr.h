@@ -0,0 +1,48 @@
+#ifndef CExprCompiledExpr_H
+#define CExprCompiledExpr_H
+
+#include <CExprProgram.h>
+#include <memory>
+
+class CExpr;
+
+// Expression compiled once by CExpr::compile and evaluated many times.
+//
+// Owns the optimized program of the expression. Compiled programs call (or
+// have inlined bodies of) the functions defined when they were compiled, so
+// the program is compiled again on evaluation if functions or constants have
+// changed since. The CExpr must outlive the compiled expression.
+class CExprCompiledExpr {
+ public:
+  CExprCompiledExpr(CExpr *expr, const std::string &str);
+  CExprCompiledExpr(CExpr *expr, const std::string &str, const CExprTokenStack &pstack);
+
+  const std::string &str() const { return str_; }
+
+  // expression compiled without error
+  bool isValid() const { return valid_; }
+
+  const CExprProgram &program() const { return program_; }
+
+  bool evaluate(CExprValueArray &values);
+  bool evaluate(CExprValuePtr &value);
+  bool evaluate(double &r);
+  bool evaluate(long &l);
+
+ private:
+  bool compile();
+  bool update();
+
+ private:
+  CExpr*          expr_ { nullptr };
+  std::string     str_;
+  CExprTokenStack pstack_;
+  CExprITokenPtr  itoken_;
+  CExprProgram    program_;
+  uint            generation_ { 0 };
+  bool            valid_ { false };
+};
+
+using CExprCompiledExprP = std::shared_ptr<CExprCompiledExpr>;
+
+#endif
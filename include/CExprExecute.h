@@ -2,6 +2,7 @@
 #define CExprExecute_H
 
 class CExpr;
+class CExprProgram;
 class CExprExecuteImpl;
 
 class CExprExecute {
@@ -11,8 +12,10 @@ class CExprExecute {
 
   CExpr *expr() const { return expr_; }
 
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values);
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value);
+  // run program. Operator with invalid operands gives no (null) value and
+  // does not fail the evaluation
+  bool executeProgram(const CExprProgram &program, CExprValueArray &values);
+  bool executeProgram(const CExprProgram &program, CExprValuePtr &value);
 
  private:
   using CExprExecuteImplP = std::unique_ptr<CExprExecuteImpl>;
@@ -30,7 +30,7 @@ struct CExprFunctionArg {
 
 //------
 
-class CExprFunction {
+class CExprFunction : public CExprRefCounted {
  public:
   CExprFunction(const std::string &name) :
    name_(name) {
@@ -46,16 +46,32 @@ class CExprFunction {
   bool isVariableArgs() const { return variableArgs_; }
   void setVariableArgs(bool b) { variableArgs_ = b; }
 
+  // user function (defined by expression)
+  virtual bool isUser() const { return false; }
+
   virtual uint numArgs() const = 0;
 
   virtual CExprValueType argType(uint) const { return CExprValueType::ANY; }
 
+  // pure function has no side effects and result only depends on arguments
+  bool isPure() const { return pure_; }
+  void setPure(bool b) { pure_ = b; }
+
+  // type of result value (NONE if depends on arguments)
+  CExprValueType resultType() const { return resultType_; }
+  void setResultType(CExprValueType type) { resultType_ = type; }
+
   virtual bool checkValues(const CExprValueArray &) const { return true; }
 
   virtual bool hasFunction(const std::string &) const { return false; }
 
   virtual void reset() { }
 
+  // function called with typed argument values in place (see CExprTypedFunction)
+  virtual bool isTyped() const { return false; }
+
+  virtual bool execTyped(CExpr *, const CExprValuePtr *, CExprValuePtr &) { return false; }
+
   virtual CExprValuePtr exec(CExpr *expr, const CExprValueArray &values) = 0;
 
   friend std::ostream &operator<<(std::ostream &os, const CExprFunction &fn) {
@@ -74,9 +90,11 @@ class CExprFunction {
   }
 
  protected:
-  std::string name_;
-  bool        builtin_      { false };
-  bool        variableArgs_ { false };
+  std::string    name_;
+  bool           builtin_      { false };
+  bool           variableArgs_ { false };
+  bool           pure_         { false };
+  CExprValueType resultType_   { CExprValueType::NONE };
 };
 
 //------
@@ -138,8 +156,12 @@ class CExprUserFunction : public CExprFunction {
  public:
   CExprUserFunction(const std::string &name, const Args &args, const std::string &proc);
 
+  bool isUser() const override { return true; }
+
   uint numArgs() const override { return uint(args_.size()); }
 
+  const Args &args() const { return args_; }
+
   const std::string &proc() const { return proc_; }
 
   bool checkValues(const CExprValueArray &) const override;
@@ -148,10 +170,16 @@ class CExprUserFunction : public CExprFunction {
 
   bool isCompiled() const { return compiled_; }
 
+  // compile body if not compiled or functions changed since compiled (fails if
+  // already being compiled i.e. recursive)
+  bool compile(CExpr *expr) const;
+
+  const CExprProgram &program() const { return program_; }
+
   CExprValuePtr exec(CExpr *expr, const CExprValueArray &values) override;
 
   bool hasFunction(const std::string &name) const override {
-    return compiled_ && cstack_.hasFunction(name);
+    return compiled_ && program_.hasFunction(name);
   }
 
   void print(std::ostream &os, bool expanded=true) const override {
@@ -169,13 +197,25 @@ class CExprUserFunction : public CExprFunction {
       os << "= " << proc_;
   }
 
+ private:
+  // variable hidden by arg value while body is executed
+  struct ArgVariable {
+    CExprVariablePtr      variable;
+    CExprVariable::Shadow shadow;
+    bool                  created { false };
+  };
+
+  using ArgVariables = std::vector<ArgVariable>;
+
  private:
   Args                    args_;
   std::string             proc_;
   mutable bool            compiled_ { false };
+  mutable bool            compiling_ { false };
+  mutable uint            generation_ { 0 };
   mutable CExprTokenStack pstack_;
   mutable CExprITokenPtr  itoken_;
-  mutable CExprTokenStack cstack_;
+  mutable CExprProgram    program_;
 };
 
 //------
@@ -2,7 +2,13 @@
 #define CExprFunctionMgr_H
 
 #include <list>
+#include <map>
+#include <unordered_map>
 
+// Functions of a CExpr.
+//
+// Functions are kept in the order they were added and are indexed by name, with
+// the overloads of a name also indexed by their number of arguments.
 class CExprFunctionMgr {
  public:
   friend class CExpr;
@@ -22,10 +28,15 @@ class CExprFunctionMgr {
 
   void getFunctions(const std::string &name, Functions &functions);
 
+  // function to call with number of arguments (first added overload with number of
+  // arguments or last added overload if none)
+  CExprFunctionPtr findFunction(const std::string &name, uint numArgs);
+
   CExprFunctionPtr addProcFunction(const std::string &name, const std::string &args,
                                    CExprFunctionProc proc);
   CExprFunctionPtr addObjFunction (const std::string &name, const std::string &args,
                                    CExprFunctionObj *proc);
+  CExprFunctionPtr addTypedFunction(CExprFunction *function);
   CExprFunctionPtr addUserFunction(const std::string &name, const std::vector<std::string> &args,
                                    const std::string &proc);
 
@@ -34,16 +45,34 @@ class CExprFunctionMgr {
 
   void getFunctionNames(std::vector<std::string> &names) const;
 
+  // incremented when functions change (compiled user functions and programs are out of
+  // date)
+  uint generation() const { return generation_; }
+
   static bool parseArgs(const std::string &argsStr, Args &args, bool &variableArgs);
 
  private:
+  void addFunction(CExprFunctionPtr function);
+
   void resetCompiled();
 
  private:
-  using FunctionList = std::list<CExprFunctionPtr>;
+  using FunctionList   = std::list<CExprFunctionPtr>;
+  using Positions      = std::vector<FunctionList::iterator>;
+  using ArityFunctions = std::map<uint, Functions>;
+
+  // functions with same name in order added and by number of arguments
+  struct NameFunctions {
+    Positions      positions;
+    ArityFunctions arityFunctions;
+  };
+
+  using NameMap = std::unordered_map<std::string, NameFunctions>;
 
   CExpr*       expr_ { nullptr };
   FunctionList functions_;
+  NameMap      nameMap_;
+  uint         generation_ { 0 };
 };
 
 #endif
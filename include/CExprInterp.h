@@ -1,7 +1,7 @@
 #ifndef CExprInterp_H
 #define CExprInterp_H
 
-class CExprIToken {
+class CExprIToken : public CExprRefCounted {
  public:
   static CExprITokenPtr createIToken(CExprITokenType itype) {
     return CExprITokenPtr(new CExprIToken(itype));
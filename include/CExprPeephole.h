@@ -0,0 +1,53 @@
+#ifndef CExprPeephole_H
+#define CExprPeephole_H
+
+#include <CExprProgram.h>
+#include <map>
+
+class CExpr;
+
+// Peephole optimizer for compiled programs.
+//
+// Replaces common instruction sequences by single superinstructions:
+//   load(a) push(c) <binary>        -> binary_var_const(a,c)
+//   load(a) load(b) <binary>        -> binary_var_var(a,b)
+//   <compare> jump_if_false/true(t) -> binary_jump_if_false/true(t)
+//
+// The number of times each fusion is made (keyed by fusion and operator) is
+// kept so the pattern set can be checked against real expressions.
+class CExprPeephole {
+ public:
+  using Counts = std::map<std::string, uint>;
+
+ public:
+  CExprPeephole(CExpr *expr) :
+   expr_(expr) {
+  }
+
+  // optimize program in place (returns true if changed)
+  bool optimize(CExprProgram &program);
+
+  const Counts &counts() const { return counts_; }
+
+  void resetCounts() { counts_.clear(); }
+
+  void printCounts(std::ostream &os) const;
+
+ private:
+  using Instructions = CExprProgram::Instructions;
+  using Targets      = std::vector<bool>;
+
+  uint fuseInstructions(const CExprProgram &program, uint i, const Targets &isTarget,
+                        CExprInstruction &fused) const;
+
+  static bool isBinaryOpCode(CExprOpCode code);
+  static bool isCompareOp(CExprOpType op);
+
+  void addCount(const CExprInstruction &fused);
+
+ private:
+  CExpr* expr_ { nullptr };
+  Counts counts_;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef CExprProgram_H
+#define CExprProgram_H
+
+#include <CExprTypes.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+class CExprRegisterCode;
+
+enum class CExprOpCode : unsigned char {
+  NOP,
+  PUSH_VALUE,          // push constant value (arg1 = value index)
+  PUSH_NULL,           // push null value (omitted optional function argument)
+  LOAD_VAR,            // push variable value (arg1 = identifier index)
+  STORE_VAR,           // assign top value to variable (arg1 = identifier index)
+  POP,                 // discard top value
+  UNARY_OP,            // numeric unary operator (op)
+  LOGICAL_UNARY_OP,    // boolean unary operator (op)
+  BITWISE_UNARY_OP,    // integer unary operator (op)
+  BINARY_OP,           // numeric/comparison binary operator (op)
+  LOGICAL_BINARY_OP,   // boolean binary operator (op)
+  BITWISE_BINARY_OP,   // integer binary operator (op)
+  CALL,                // call function (arg1 = function index, arg2 = num args)
+  JUMP,                // jump to instruction (arg1 = instruction index)
+  JUMP_IF_FALSE,       // pop condition and jump if false (arg1 = instruction index)
+  JUMP_IF_TRUE,        // pop condition and jump if true (arg1 = instruction index)
+                       // (conditional jump op is QUESTION for ?: where a non-boolean
+                       //  condition is false, or LOGICAL_AND/LOGICAL_OR for && and ||
+                       //  where a non-boolean operand is an error)
+  UNARY_OP_I,          // UNARY_OP on integer
+  UNARY_OP_R,          // UNARY_OP on real
+  BINARY_OP_II,        // BINARY_OP on integer, integer
+  BINARY_OP_RR,        // BINARY_OP on real, real
+  BINARY_OP_IR,        // BINARY_OP on integer, real (integer promoted to real)
+  BINARY_OP_RI,        // BINARY_OP on real, integer (integer promoted to real)
+                       // (typed operators are selected from operand types inferred at
+                       //  compile time and fall back to UNARY_OP/BINARY_OP if the
+                       //  operand types differ at run time)
+  STORE_TEMP,          // copy top value to temporary (arg1 = temporary index)
+  LOAD_TEMP,           // push temporary value (arg1 = temporary index)
+  BINARY_VAR_CONST,    // push variable <op> constant (arg1 = identifier index,
+                       //  arg2 = value index, fused = binary opcode)
+  BINARY_VAR_VAR,      // push variable <op> variable (arg1, arg2 = identifier index,
+                       //  fused = binary opcode)
+  BINARY_JUMP_IF_FALSE,// pop two values, compare and jump if false (arg1 = instruction index,
+                       //  fused = binary opcode)
+  BINARY_JUMP_IF_TRUE, // pop two values, compare and jump if true (arg1 = instruction index,
+                       //  fused = binary opcode)
+                       // (superinstructions are only made by CExprPeephole)
+  POWER_INT,           // raise top value to constant integer power (arg1 = exponent)
+  MOVE                 // copy operand to register (register code only)
+};
+
+// Single instruction of a compiled program.
+//
+// Operands are stored inline and index into the program's constant, identifier
+// and function pools. The handler is the address of the executor code for
+// the opcode (threaded dispatch) and is set for all instructions of the program
+// on first execution. The fused opcode is the operator opcode of a
+// superinstruction (arg2 is the jump operator of a fused compare and jump).
+struct CExprInstruction {
+  CExprOpCode   code    { CExprOpCode::NOP };
+  CExprOpCode   fused   { CExprOpCode::NOP };
+  CExprOpType   op      { CExprOpType::UNKNOWN };
+  uint          arg1    { 0 };
+  uint          arg2    { 0 };
+  mutable void* handler { nullptr };
+
+  CExprInstruction() { }
+
+  CExprInstruction(CExprOpCode code, CExprOpType op=CExprOpType::UNKNOWN,
+                   uint arg1=0, uint arg2=0) :
+   code(code), op(op), arg1(arg1), arg2(arg2) {
+  }
+};
+
+// Compiled expression. Flat array of instructions executed by CExprExecute
+// using a value stack.
+class CExprProgram {
+ public:
+  using Instructions = std::vector<CExprInstruction>;
+  using Values       = std::vector<CExprValuePtr>;
+  using Identifiers  = std::vector<std::string>;
+  using Variables    = std::vector<CExprVariablePtr>;
+  using Functions    = std::vector<CExprFunctionPtr>;
+
+ public:
+  CExprProgram() { }
+
+  bool empty() const { return instructions_.empty(); }
+
+  uint numInstructions() const { return uint(instructions_.size()); }
+
+  const Instructions &instructions() const { return instructions_; }
+
+  const CExprInstruction &instruction(uint i) const { return instructions_[i]; }
+
+  uint addInstruction(const CExprInstruction &instruction);
+
+  // replace opcode of instruction (same operands and stack effect)
+  void setOpCode(uint i, CExprOpCode code);
+
+  // replace instructions by optimized instructions (same result and max depth)
+  void setInstructions(const Instructions &instructions);
+
+  // remove last instruction (and its value if not used by other instructions)
+  void removeLastInstruction();
+
+  // threaded dispatch handlers set for all instructions (reset when instructions
+  // are changed)
+  bool isHandlersResolved() const { return handlersResolved_; }
+  void setHandlersResolved() const { handlersResolved_ = true; }
+
+  // set target of jump instruction
+  void setJumpTarget(uint i, uint target);
+
+  // highest jump target (instructions from here to end are straight line code)
+  uint lastJumpTarget() const { return lastJumpTarget_; }
+
+  // max operand stack depth needed to execute instructions
+  uint maxDepth() const { return maxDepth_; }
+
+  // current stack depth at end of instructions (reset at start of alternate branch)
+  int  depth() const { return depth_; }
+  void setDepth(int depth) { depth_ = depth; }
+
+  static int stackEffect(const CExprInstruction &instruction);
+
+  static bool isJump(CExprOpCode code);
+
+  //---
+
+  uint numValues() const { return uint(values_.size()); }
+
+  const CExprValuePtr &value(uint i) const { return values_[i]; }
+
+  uint addValue(const CExprValuePtr &value);
+
+  //---
+
+  uint numIdentifiers() const { return uint(identifiers_.size()); }
+
+  const std::string &identifier(uint i) const { return identifiers_[i]; }
+
+  uint addIdentifier(const std::string &name);
+
+  // variable of identifier. Variables are bound when the program is compiled or, if
+  // they don't exist then, when first used and are looked up again if removed
+  const CExprVariablePtr &variable(CExpr *expr, uint i) const;
+
+  void setVariable(uint i, const CExprVariablePtr &variable) const;
+
+  void bindVariables(CExpr *expr) const;
+
+  //---
+
+  uint numFunctions() const { return uint(functions_.size()); }
+
+  const CExprFunctionPtr &function(uint i) const { return functions_[i]; }
+
+  uint addFunction(const CExprFunctionPtr &function);
+
+  //---
+
+  // temporaries hold values of common subexpressions
+  uint numTemps() const { return numTemps_; }
+
+  uint addTemp() { return numTemps_++; }
+
+  //---
+
+  bool hasFunction(const std::string &name) const;
+
+  // number of constant expressions folded by compiler
+  uint numFolded() const { return numFolded_; }
+  void setNumFolded(uint n) { numFolded_ = n; }
+
+  //---
+
+  // register form of program (null if not built or unsupported)
+  const CExprRegisterCode *registerCode() const { return registerCode_.get(); }
+
+  bool buildRegisterCode();
+
+  //---
+
+  void clear();
+
+  void print(std::ostream &os) const;
+
+  void printInstruction(std::ostream &os, const CExprInstruction &instruction) const;
+
+  friend std::ostream &operator<<(std::ostream &os, const CExprProgram &program) {
+    program.print(os);
+
+    return os;
+  }
+
+  static const char *opCodeName(CExprOpCode code);
+
+ private:
+  void instructionsChanged();
+
+ private:
+  Instructions instructions_;
+  Values       values_;
+  Identifiers  identifiers_;
+  mutable Variables variables_;
+  Functions    functions_;
+  int          depth_    { 0 };
+  uint         maxDepth_ { 0 };
+  uint         lastJumpTarget_ { 0 };
+  uint         numFolded_ { 0 };
+  uint         numTemps_ { 0 };
+  mutable bool handlersResolved_ { false };
+
+  std::shared_ptr<CExprRegisterCode> registerCode_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CExprProgramCache_H
+#define CExprProgramCache_H
+
+#include <list>
+#include <unordered_map>
+
+class CExpr;
+
+// Least recently used cache of compiled expressions used by
+// CExpr::evaluateExpression.
+//
+// Expressions are keyed by their text or (if normalized) by their parsed token
+// stream, so expressions which only differ in spacing share an entry but still
+// need to be parsed. The cache is disabled when max entries is zero and is
+// cleared when functions or constants change. The size in bytes of an entry is
+// an estimate.
+class CExprProgramCache {
+ public:
+  struct Stats {
+    ulong  hits          { 0 }; // lookups of cached expression
+    ulong  misses        { 0 }; // lookups which compiled expression
+    ulong  evictions     { 0 }; // entries removed to keep within capacity
+    ulong  invalidations { 0 }; // clears for function or constant change
+    uint   numEntries    { 0 }; // current entries
+    size_t numBytes      { 0 }; // current estimated size
+  };
+
+ public:
+  CExprProgramCache(CExpr *expr) :
+   expr_(expr) {
+  }
+
+  bool isEnabled() const { return maxEntries_ > 0; }
+
+  uint maxEntries() const { return maxEntries_; }
+
+  size_t maxBytes() const { return maxBytes_; }
+
+  // set capacity (zero max entries disables cache, zero max bytes is no byte limit)
+  void setCapacity(uint maxEntries, size_t maxBytes=0);
+
+  bool isNormalize() const { return normalize_; }
+  void setNormalize(bool b);
+
+  // compiled expression for string (null if invalid)
+  CExprCompiledExprP lookup(const std::string &str);
+
+  void clear();
+
+  const Stats &stats() const { return stats_; }
+
+  void resetStats();
+
+ private:
+  struct Entry {
+    std::string        key;
+    CExprCompiledExprP compiledExpr;
+    size_t             bytes { 0 };
+  };
+
+  using Entries   = std::list<Entry>;
+  using EntryMap  = std::unordered_map<std::string, Entries::iterator>;
+
+  static std::string tokenKey(const CExprTokenStack &pstack);
+
+  static size_t entryBytes(const Entry &entry);
+
+  void trim(uint maxEntries, size_t maxBytes);
+
+ private:
+  CExpr*   expr_       { nullptr };
+  uint     maxEntries_ { 0 };
+  size_t   maxBytes_   { 0 };
+  bool     normalize_  { false };
+  uint     generation_ { 0 };
+  Entries  entries_; // most recently used first
+  EntryMap entryMap_;
+  Stats    stats_;
+};
+
+#endif
@@ -1,32 +1,28 @@
 #ifndef CExprRealValue_H
 #define CExprRealValue_H
 
-class CExprRealValue : public CExprValueBase {
+class CExprRealValue {
  public:
   CExprRealValue(double real) :
    real_(real) {
   }
 
-  CExprRealValue *dup() const override {
-    return new CExprRealValue(real_);
-  }
-
-  bool getBooleanValue(bool        &b) const override { b = (real_ != 0); return true; }
-  bool getIntegerValue(long        &l) const override { l = long(real_) ; return true; }
-  bool getRealValue   (double      &r) const override { r = real_       ; return true; }
-  bool getStringValue (std::string &s) const override;
+  bool getBooleanValue(bool        &b) const { b = (real_ != 0); return true; }
+  bool getIntegerValue(long        &l) const { l = long(real_) ; return true; }
+  bool getRealValue   (double      &r) const { r = real_       ; return true; }
+  bool getStringValue (std::string &s) const;
 
-  void setRealValue(double r) override { real_ = r; }
+  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const;
+  CExprValuePtr execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const;
 
-  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const override;
-  CExprValuePtr execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const override;
-
-  void print(std::ostream &os) const override {
+  void print(std::ostream &os) const {
     os << real_;
   }
 
+  static double realPower       (double real1, double real2, int *error_code);
+  static double realIntegerPower(double real1, long integer2, int *error_code);
+
  private:
-  double realPower  (double real1, double real2, int *error_code) const;
   double realModulus(double real1, double real2, int *error_code) const;
 
  private:
@@ -0,0 +1,147 @@
+#ifndef CExprRefPtr_H
+#define CExprRefPtr_H
+
+#include <sys/types.h>
+#include <cstddef>
+
+#ifdef CEXPR_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
+
+// Intrusive reference count for expression engine objects.
+//
+// The engine is single threaded so the count is a plain integer by default,
+// define CEXPR_ATOMIC_REFCOUNT if objects are shared between threads.
+class CExprRefCounted {
+ public:
+  CExprRefCounted() { }
+
+  // copied objects start with their own (zero) count
+  CExprRefCounted(const CExprRefCounted &) { }
+
+  CExprRefCounted &operator=(const CExprRefCounted &) { return *this; }
+
+  uint refCount() const { return refCount_; }
+
+  void incRef() const { ++refCount_; }
+  uint decRef() const { return --refCount_; }
+
+ private:
+#ifdef CEXPR_ATOMIC_REFCOUNT
+  using Count = std::atomic<uint>;
+#else
+  using Count = uint;
+#endif
+
+  mutable Count refCount_ { 0 };
+};
+
+//---
+
+// destroy object when last reference released (overload to recycle objects)
+template<typename T>
+inline void CExprRefPtrDestroy(T *p) {
+  delete p;
+}
+
+//---
+
+// handle to CExprRefCounted derived object (deleted when last handle released)
+template<typename T>
+class CExprRefPtr {
+ public:
+  CExprRefPtr() { }
+
+  CExprRefPtr(std::nullptr_t) { }
+
+  explicit CExprRefPtr(T *p) :
+   p_(p) {
+    acquire();
+  }
+
+  CExprRefPtr(const CExprRefPtr &ptr) :
+   p_(ptr.p_) {
+    acquire();
+  }
+
+  CExprRefPtr(CExprRefPtr &&ptr) noexcept :
+   p_(ptr.p_) {
+    ptr.p_ = nullptr;
+  }
+
+  template<typename U>
+  CExprRefPtr(const CExprRefPtr<U> &ptr) :
+   p_(ptr.get()) {
+    acquire();
+  }
+
+ ~CExprRefPtr() {
+    release();
+  }
+
+  CExprRefPtr &operator=(const CExprRefPtr &ptr) {
+    if (ptr.p_ != p_) {
+      ptr.acquire();
+
+      release();
+
+      p_ = ptr.p_;
+    }
+
+    return *this;
+  }
+
+  CExprRefPtr &operator=(CExprRefPtr &&ptr) noexcept {
+    if (&ptr != this) {
+      release();
+
+      p_ = ptr.p_;
+
+      ptr.p_ = nullptr;
+    }
+
+    return *this;
+  }
+
+  T *get() const { return p_; }
+
+  T *operator->() const { return p_; }
+  T &operator* () const { return *p_; }
+
+  explicit operator bool() const { return (p_ != nullptr); }
+
+  bool isValid() const { return (p_ != nullptr); }
+
+  // single owner (safe to modify in place)
+  bool isUnique() const { return (p_ && p_->refCount() == 1); }
+
+  void reset() {
+    release();
+
+    p_ = nullptr;
+  }
+
+  friend bool operator==(const CExprRefPtr &lhs, const CExprRefPtr &rhs) {
+    return (lhs.p_ == rhs.p_);
+  }
+
+  friend bool operator!=(const CExprRefPtr &lhs, const CExprRefPtr &rhs) {
+    return (lhs.p_ != rhs.p_);
+  }
+
+ private:
+  void acquire() const {
+    if (p_)
+      p_->incRef();
+  }
+
+  void release() {
+    if (p_ && p_->decRef() == 0)
+      CExprRefPtrDestroy(p_);
+  }
+
+ private:
+  T *p_ { nullptr };
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef CExprRegisterCode_H
+#define CExprRegisterCode_H
+
+#include <CExprProgram.h>
+
+// Operand of register instruction. Constants and variables are referenced
+// directly from the program pools so they are never copied to registers.
+struct CExprRegOperand {
+  enum class Type : unsigned char {
+    NONE,
+    REG,   // virtual register
+    CONST, // program constant value
+    VAR,   // program identifier (variable value)
+    TEMP,  // program temporary
+    NUL    // null value
+  };
+
+  Type type { Type::NONE };
+  uint ind  { 0 };
+
+  CExprRegOperand() { }
+
+  CExprRegOperand(Type type, uint ind=0) :
+   type(type), ind(ind) {
+  }
+};
+
+// Single register instruction: dst = lhs <op> rhs
+//
+// STORE_VAR assigns lhs to variable 'arg', STORE_TEMP assigns lhs to temporary 'arg', CALL calls function 'arg' with
+// 'numArgs' arguments in consecutive registers starting at dst and jumps go to
+// instruction 'arg' (JUMP_IF_FALSE/JUMP_IF_TRUE test lhs).
+struct CExprRegInstruction {
+  CExprOpCode     code    { CExprOpCode::NOP };
+  CExprOpType     op      { CExprOpType::UNKNOWN };
+  uint            dst     { 0 };
+  CExprRegOperand lhs;
+  CExprRegOperand rhs;
+  uint            arg     { 0 };
+  uint            numArgs { 0 };
+};
+
+// Register form of a compiled program.
+//
+// Built from the stack code by simulating the operand stack: stack slot 'k' is
+// virtual register 'k' and pushes of constants and variables become operands of
+// the instruction which consumes them. All stack values are in registers at jumps
+// and jump targets so every path into an instruction has the same stack.
+class CExprRegisterCode {
+ public:
+  using Instructions = std::vector<CExprRegInstruction>;
+  using Operands     = std::vector<CExprRegOperand>;
+
+ public:
+  CExprRegisterCode() { }
+
+  // build from program (returns false if program uses unsupported instructions)
+  bool build(const CExprProgram &program);
+
+  uint numRegisters() const { return numRegisters_; }
+
+  const Instructions &instructions() const { return instructions_; }
+
+  // operands holding result values after execution
+  const Operands &results() const { return results_; }
+
+  void print(std::ostream &os, const CExprProgram &program) const;
+
+ private:
+  struct Labels {
+    std::vector<bool> isTarget;           // instruction is jump target
+    std::vector<int>  depth;              // stack depth at target (-1 if not known)
+    std::vector<uint> regIndex;           // register instruction index of instruction
+    bool              reachable { true }; // previous instruction falls through
+  };
+
+  bool startInstruction(Labels &labels, Operands &stack, uint pc);
+
+  static bool setTargetDepth(Labels &labels, uint target, uint depth);
+
+  void addInstruction(const CExprRegInstruction &instruction);
+
+  void materialize(Operands &stack, uint i);
+
+  void materializeAll(Operands &stack, uint n);
+
+  static void printOperand(std::ostream &os, const CExprProgram &program,
+                           const CExprRegOperand &operand);
+
+ private:
+  Instructions instructions_;
+  Operands     results_;
+  uint         numRegisters_ { 0 };
+};
+
+#endif
@@ -1,27 +1,21 @@
 #ifndef CExprStringValue_H
 #define CExprStringValue_H
 
-class CExprStringValue : public CExprValueBase {
+class CExprStringValue {
  public:
   CExprStringValue(const std::string &str) :
    str_(str) {
   }
 
-  CExprStringValue *dup() const override {
-    return new CExprStringValue(str_);
-  }
-
-  bool getBooleanValue(bool        &b) const override;
-  bool getIntegerValue(long        &l) const override;
-  bool getRealValue   (double      &r) const override;
-  bool getStringValue (std::string &s) const override { s = str_; return true; }
-
-  void setStringValue(const std::string &s) override { str_ = s; }
+  bool getBooleanValue(bool        &b) const;
+  bool getIntegerValue(long        &l) const;
+  bool getRealValue   (double      &r) const;
+  bool getStringValue (std::string &s) const { s = str_; return true; }
 
-  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const override;
-  CExprValuePtr execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const override;
+  CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const;
+  CExprValuePtr execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const;
 
-  void print(std::ostream &os) const override {
+  void print(std::ostream &os) const {
     os << str_;
   }
 
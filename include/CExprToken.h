@@ -143,22 +143,4 @@ class CExprTokenValue : public CExprTokenBase {
 
 #include <CExprTokenStack.h>
 
-//---
-
-class CExprTokenBlock : public CExprTokenBase {
- public:
-  CExprTokenBlock(const CExprTokenStack &stack) :
-   CExprTokenBase(CExprTokenType::BLOCK), stack_(stack) {
-  }
-
-  const CExprTokenStack &stack() const { return stack_; }
-
-  //CExprTokenBlock *dup() const override { return new CExprTokenBlock(stack_); }
-
-  void print(std::ostream &os) const override { stack_.print(os); }
-
- private:
-  CExprTokenStack stack_;
-};
-
 #endif
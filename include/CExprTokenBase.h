@@ -8,7 +8,7 @@
 
 class CExprTokenStack;
 
-class CExprTokenBase {
+class CExprTokenBase : public CExprRefCounted {
  public:
   CExprTokenBase(CExprTokenType type) :
    type_(type) {
@@ -27,7 +27,6 @@ class CExprTokenBase {
   const std::string     &getString    () const;
   CExprFunctionPtr       getFunction  () const;
   CExprValuePtr          getValue     () const;
-  const CExprTokenStack &getBlock     () const;
 
   void printQualified(std::ostream &os) const;
 
@@ -37,6 +36,6 @@ class CExprTokenBase {
   CExprTokenType type_ { CExprTokenType::UNKNOWN };
 };
 
-using CExprTokenBaseP = std::shared_ptr<CExprTokenBase>;
+using CExprTokenBaseP = CExprRefPtr<CExprTokenBase>;
 
 #endif
@@ -0,0 +1,110 @@
+#ifndef CExprTypedFunction_H
+#define CExprTypedFunction_H
+
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+template<typename T>
+class CExprTypedFunction;
+
+// Function calling a C++ callable with typed arguments (added using
+// CExpr::addFunction<R(Args...)>).
+//
+// Argument and result types are mapped to value types by CExprUtil. The executor
+// calls execTyped with the argument values in place on the operand stack so no
+// value array is built for the call.
+template<typename R, typename... Args>
+class CExprTypedFunction<R(Args...)> : public CExprFunction {
+ public:
+  using Proc = std::function<R(Args...)>;
+
+ public:
+  CExprTypedFunction(const std::string &name, const Proc &proc) :
+   CExprFunction(name), proc_(proc) {
+    std::vector<std::string> argStrs { CExprUtil<std::decay_t<Args>>::argTypeStr()... };
+
+    std::string argsStr;
+
+    for (const auto &argStr : argStrs) {
+      if (! argsStr.empty()) argsStr += ",";
+
+      argsStr += argStr;
+    }
+
+    bool variableArgs;
+
+    (void) CExprFunctionMgr::parseArgs(argsStr, args_, variableArgs);
+
+    CExprFunctionMgr::Args resultArgs;
+
+    if (CExprFunctionMgr::parseArgs(CExprUtil<R>::argTypeStr(), resultArgs, variableArgs))
+      setResultType(resultArgs[0].type);
+  }
+
+  uint numArgs() const override { return uint(sizeof...(Args)); }
+
+  CExprValueType argType(uint i) const override {
+    return (i < args_.size() ? args_[i].type : CExprValueType::NUL);
+  }
+
+  bool checkValues(const CExprValueArray &values) const override {
+    return (values.size() == numArgs());
+  }
+
+  bool isTyped() const override { return true; }
+
+  CExprValuePtr exec(CExpr *expr, const CExprValueArray &values) override {
+    CExprValuePtr result;
+
+    if (! execTyped(expr, values.data(), result))
+      return CExprValuePtr();
+
+    return result;
+  }
+
+  bool execTyped(CExpr *expr, const CExprValuePtr *values, CExprValuePtr &result) override {
+    return call(expr, values, result, std::index_sequence_for<Args...>());
+  }
+
+ private:
+  template<size_t... I>
+  bool call(CExpr *expr, const CExprValuePtr *values, CExprValuePtr &result,
+            std::index_sequence<I...>) {
+    std::tuple<std::decay_t<Args>...> args;
+
+    bool rc = true;
+
+    (void) std::initializer_list<int>{ (rc = rc && getArg(values[I], std::get<I>(args)), 0)... };
+
+    if (! rc)
+      return false;
+
+    result = CExprUtil<R>::createValue(expr, proc_(std::get<I>(args)...));
+
+    return true;
+  }
+
+  template<typename T>
+  static bool getArg(const CExprValuePtr &value, T &v) {
+    return (value && CExprUtil<T>::getTypeValue(value, v));
+  }
+
+ private:
+  CExprFunctionMgr::Args args_;
+  Proc                   proc_;
+};
+
+//------
+
+template<typename T, typename F>
+CExprFunctionPtr
+CExpr::
+addFunction(const std::string &name, F proc)
+{
+  return addTypedFunction(new CExprTypedFunction<T>(name, proc));
+}
+
+#endif
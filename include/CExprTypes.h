@@ -1,6 +1,7 @@
 #ifndef CExprTypes_H
 #define CExprTypes_H
 
+#include <CExprRefPtr.h>
 #include <vector>
 #include <memory>
 
@@ -47,9 +48,7 @@ enum class CExprOpType {
   BIT_OR_EQUALS     = 38,
   BIT_LSHIFT_EQUALS = 39,
   BIT_RSHIFT_EQUALS = 40,
-  COMMA             = 41,
-  START_BLOCK       = 42,
-  END_BLOCK         = 43
+  COMMA             = 41
 };
 
 enum class CExprValueType {
@@ -75,8 +74,7 @@ enum class CExprTokenType {
   STRING     = 6,
   COMPLEX    = 7,
   FUNCTION   = 8,
-  VALUE      = 9,
-  BLOCK      = 10
+  VALUE      = 9
 };
 
 enum class CExprITokenType {
@@ -110,14 +108,18 @@ class CExprValue;
 class CExprIToken;
 class CExprVariable;
 class CExprFunction;
+class CExprValuePool;
 
-using CExprValuePtr    = std::shared_ptr<CExprValue>;
-using CExprITokenPtr   = std::shared_ptr<CExprIToken>;
-using CExprVariablePtr = std::shared_ptr<CExprVariable>;
-using CExprFunctionPtr = std::shared_ptr<CExprFunction>;
+using CExprValuePtr    = CExprRefPtr<CExprValue>;
+using CExprITokenPtr   = CExprRefPtr<CExprIToken>;
+using CExprVariablePtr = CExprRefPtr<CExprVariable>;
+using CExprFunctionPtr = CExprRefPtr<CExprFunction>;
 
 using CExprValueArray = std::vector<CExprValuePtr>;
 
+// values created from a CExprValuePool are returned to it
+void CExprRefPtrDestroy(CExprValue *value);
+
 using CExprFunctionProc = CExprValuePtr (*)(CExpr *expr, const CExprValueArray &values);
 using CExprVariableProc = CExprValuePtr (*)(CExprValuePtr, bool);
 
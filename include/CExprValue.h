@@ -1,9 +1,9 @@
 #ifndef CExprValue_H
 #define CExprValue_H
 
-#include <memory>
+#include <string>
 
-class CExprValue {
+class CExprValue : public CExprRefCounted {
  public:
   CExprValue();
 
@@ -12,8 +12,17 @@ class CExprValue {
   CExprValue(const CExprRealValue    &real);
   CExprValue(const CExprStringValue  &str);
 
+  CExprValue(const CExprValue &value);
+
  ~CExprValue();
 
+  CExprValue &operator=(const CExprValue &value);
+
+  CExprValuePool *pool() const { return pool_; }
+
+  // shared immutable value (see CExpr::createXXXValue)
+  bool isConstant() const { return constant_; }
+
   CExprValueType getType() const { return type_; }
   bool isType(CExprValueType type) const { return (type_ == type); }
 
@@ -33,10 +42,17 @@ class CExprValue {
   bool getRealValue   (double &r) const;
   bool getStringValue (std::string &s) const;
 
-  void setBooleanValue(bool b);
-  void setIntegerValue(long l);
-  void setRealValue   (double r);
-  void setStringValue (const std::string &s);
+  // direct access to data (value must be of matching type)
+  long   integer() const { assert(type_ == CExprValueType::INTEGER); return integer_; }
+  double real   () const { assert(type_ == CExprValueType::REAL   ); return real_   ; }
+
+  const std::string &string() const { assert(type_ == CExprValueType::STRING); return str_; }
+
+  // update data in place (fails for constant or different type value)
+  bool setBooleanValue(bool b);
+  bool setIntegerValue(long l);
+  bool setRealValue   (double r);
+  bool setStringValue (const std::string &s);
 
   bool convToType(CExprValueType type);
 
@@ -46,7 +62,7 @@ class CExprValue {
   bool convToString ();
 
   CExprValuePtr execUnaryOp (CExpr *expr, CExprOpType op) const;
-  CExprValuePtr execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const;
+  CExprValuePtr execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const;
 
   void print(std::ostream &os) const;
 
@@ -57,10 +73,24 @@ class CExprValue {
   }
 
  private:
-  using CExprValueBaseP = std::unique_ptr<CExprValueBase>;
+  friend class CExpr;
+  friend class CExprValuePool;
 
-  CExprValueType  type_ { CExprValueType::NONE };
-  CExprValueBaseP base_;
+  bool setType(CExprValueType type);
+
+ private:
+  CExprValuePool* pool_     { nullptr };
+  bool            constant_ { false };
+
+  // value data (only member for type_ is valid)
+  CExprValueType type_ { CExprValueType::NONE };
+
+  union {
+    bool        boolean_;
+    long        integer_;
+    double      real_;
+    std::string str_;
+  };
 };
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef CExprValuePool_H
+#define CExprValuePool_H
+
+#include <vector>
+
+// Recycling pool for the values created by a CExpr.
+//
+// Values return to the pool's free list when their last reference is released.
+// The pool is owned by the CExpr but may outlive it (detach) while values created
+// from it are still referenced.
+class CExprValuePool {
+ public:
+  struct Stats {
+    ulong hits      { 0 }; // allocations satisfied from free list
+    ulong misses    { 0 }; // allocations from global heap
+    uint  inUse     { 0 }; // currently referenced values
+    uint  highWater { 0 }; // max in use values
+    uint  numFree   { 0 }; // values on free list
+  };
+
+ public:
+  CExprValuePool();
+
+  uint maxFree() const { return maxFree_; }
+  void setMaxFree(uint n);
+
+  const Stats &stats() const { return stats_; }
+
+  void resetStats();
+
+  CExprValue *alloc();
+
+  void release(CExprValue *value);
+
+  // owner is finished with pool (deleted when no values in use)
+  void detach();
+
+ private:
+ ~CExprValuePool();
+
+  void trimFree(uint n);
+
+ private:
+  using Values = std::vector<CExprValue *>;
+
+  uint   maxFree_  { 4096 };
+  Values free_;
+  Stats  stats_;
+  bool   detached_ { false };
+};
+
+#endif
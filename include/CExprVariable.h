@@ -13,7 +13,22 @@ class CExprVariableObj {
   virtual CExprValuePtr subscript(const CExprValueArray &) { return CExprValuePtr(); }
 };
 
-class CExprVariable {
+class CExprVariable : public CExprRefCounted {
+ private:
+  struct Bind {
+    CExpr*         expr { nullptr };
+    CExprValueType type { CExprValueType::NONE };
+    void*          data { nullptr };
+  };
+
+ public:
+  // value, object and binding of variable hidden by local value
+  struct Shadow {
+    CExprValuePtr     value;
+    CExprVariableObj *obj { nullptr };
+    Bind              bind;
+  };
+
  public:
   CExprVariable(const std::string &name, const CExprValuePtr &value);
  ~CExprVariable();
@@ -22,22 +37,52 @@ class CExprVariable {
   CExprValuePtr      value() const { return value_; }
 
   CExprValuePtr getValue() const;
-  void setValue(const CExprValuePtr &value);
+
+  // set value (fails if value can't be stored in bound memory)
+  bool setValue(const CExprValuePtr &value);
 
   void setRealValue   (CExpr *expr, double r);
   void setIntegerValue(CExpr *expr, long   i);
 
   CExprValueType getValueType() const;
 
+  // constant value is substituted when expressions are compiled
+  bool isConstant() const { return constant_ && ! obj_ && ! bind_.data; }
+  void setConstant(bool b) { constant_ = b; }
+
   CExprVariableObj *obj() const { return obj_; }
   void setObj(CExprVariableObj *obj) { obj_ = obj; }
 
+  // removed from variable manager (programs bound to variable must look up name again)
+  bool isRemoved() const { return removed_; }
+  void setRemoved(bool b) { removed_ = b; }
+
+  // value is read from and assigned to host memory of type (REAL for double, INTEGER
+  // for long or STRING for read only null terminated chars) instead of being stored
+  // in variable (null data removes binding)
+  bool isBound() const { return bind_.data != nullptr; }
+
+  void bind(CExpr *expr, CExprValueType type, void *data);
+
+  // replace value, object and binding by local value (e.g. user function argument)
+  // until unshadow
+  void shadow(const CExprValuePtr &value, Shadow &shadow);
+  void unshadow(const Shadow &shadow);
+
   void print(std::ostream &os) const { os << name_; }
 
+ private:
+  bool isValueOwner() const;
+
+  void updateBoundValue() const;
+
  private:
   std::string       name_;
-  CExprValuePtr     value_;
+  mutable CExprValuePtr value_; // last value read from bound memory if bound
   CExprVariableObj *obj_ { nullptr };
+  Bind              bind_;
+  bool              constant_ { false };
+  bool              removed_ { false };
 };
 
 #endif
@@ -1,12 +1,21 @@
 #ifndef CExprVariableMgr_H
 #define CExprVariableMgr_H
 
-#include <list>
+#include <vector>
 
 class CExpr;
 
 class CExprVariableObj;
 
+// Variables of a CExpr.
+//
+// Variables are kept in creation order (for getVariableNames) and found by name
+// through an open addressing hash table (linear probing) of indices into the
+// variables with the hash of each name stored in its slot.
+//
+// A variable object is kept for its name until it is removed (creating an existing
+// variable only changes its value) so compiled programs can keep the variables
+// they use.
 class CExprVariableMgr {
  public:
   CExprVariableMgr(CExpr *expr);
@@ -22,6 +31,8 @@ class CExprVariableMgr {
 
   void getVariableNames(std::vector<std::string> &names) const;
 
+  uint numVariables() const { return numVariables_; }
+
  private:
   friend class CExpr;
 
@@ -29,10 +40,29 @@ class CExprVariableMgr {
   void removeVariable(CExprVariablePtr variable);
 
  private:
-  using VariableList = std::list<CExprVariablePtr>;
+  // hash table slot (ind is variable index + 1, zero if empty or removedInd)
+  struct Slot {
+    size_t hash { 0 };
+    uint   ind  { 0 };
+  };
+
+  using Variables = std::vector<CExprVariablePtr>;
+  using Slots     = std::vector<Slot>;
+
+  static const uint removedInd = uint(-1);
+
+  static size_t nameHash(const std::string &name);
 
-  CExpr*       expr_ { nullptr };
-  VariableList variables_;
+  int findSlot(const std::string &name, size_t hash) const;
+
+  void rehash();
+
+ private:
+  CExpr*    expr_ { nullptr };
+  Variables variables_;           // creation order (null if removed)
+  uint      numVariables_ { 0 };  // variables not removed
+  Slots     slots_;               // size is power of two
+  uint      numUsedSlots_ { 0 };  // slots not empty (including removed)
 };
 
 #endif
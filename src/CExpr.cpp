@@ -1,5 +1,6 @@
 #include <CExprI.h>
 #include <CPrintF.h>
+#include <cmath>
 
 CExpr *
 CExpr::
@@ -18,6 +19,10 @@ instance()
 CExpr::
 CExpr()
 {
+  valuePool_ = new CExprValuePool;
+
+  createConstantValues();
+
   parse_   = std::make_unique<CExprParse  >(this);
   interp_  = std::make_unique<CExprInterp >(this);
   compile_ = std::make_shared<CExprCompile>(this);
@@ -26,6 +31,9 @@ CExpr()
   operatorMgr_ = std::make_unique<CExprOperatorMgr>(this);
   variableMgr_ = std::make_unique<CExprVariableMgr>(this);
   functionMgr_ = std::make_unique<CExprFunctionMgr>(this);
+  peephole_    = std::make_unique<CExprPeephole   >(this);
+
+  programCache_ = std::make_unique<CExprProgramCache>(this);
 
   functionMgr_->addFunctions();
 }
@@ -33,12 +41,35 @@ CExpr()
 CExpr::
 ~CExpr()
 {
+  // release values owned by engine before pool
+  programCache_ = CExprProgramCacheP();
+
+  compiles_.clear();
+  executes_.clear();
+
+  compile_     = CExprCompileP();
+  execute_     = CExprExecuteP();
+  variableMgr_ = CExprVariableMgrP();
+  functionMgr_ = CExprFunctionMgrP();
+
+  // values still referenced elsewhere keep pool alive
+  valuePool_->detach();
 }
 
 bool
 CExpr::
 evaluateExpression(const std::string &str, CExprValueArray &values)
 {
+  if (programCache_->isEnabled()) {
+    auto compiledExpr = programCache_->lookup(str);
+
+    // empty or invalid expression has no values (as for uncached evaluation)
+    if (! compiledExpr)
+      return true;
+
+    return compiledExpr->evaluate(values);
+  }
+
   auto pstack = parseLine(str);
 
   return executePTokenStack(pstack, values);
@@ -48,6 +79,18 @@ bool
 CExpr::
 evaluateExpression(const std::string &str, CExprValuePtr &value)
 {
+  if (programCache_->isEnabled()) {
+    auto compiledExpr = programCache_->lookup(str);
+
+    // empty or invalid expression has no value (as for uncached evaluation)
+    if (! compiledExpr) {
+      value = CExprValuePtr();
+      return true;
+    }
+
+    return compiledExpr->evaluate(value);
+  }
+
   auto pstack = parseLine(str);
 
   return executePTokenStack(pstack, value);
@@ -57,20 +100,20 @@ bool
 CExpr::
 executePTokenStack(const CExprTokenStack &pstack, CExprValueArray &values)
 {
-  auto itoken = interpPTokenStack(pstack);
-  auto cstack = compileIToken(itoken);
+  auto itoken  = interpPTokenStack(pstack);
+  auto program = compileIToken(itoken);
 
-  return executeCTokenStack(cstack, values);
+  return executeProgram(program, values);
 }
 
 bool
 CExpr::
 executePTokenStack(const CExprTokenStack &pstack, CExprValuePtr &value)
 {
-  auto itoken = interpPTokenStack(pstack);
-  auto cstack = compileIToken(itoken);
+  auto itoken  = interpPTokenStack(pstack);
+  auto program = compileIToken(itoken);
 
-  return executeCTokenStack(cstack, value);
+  return executeProgram(program, value);
 }
 
 CExprTokenStack
@@ -97,16 +140,47 @@ interpPTokenStack(const CExprTokenStack &stack)
   return itoken;
 }
 
-CExprTokenStack
+CExprProgram
 CExpr::
 compileIToken(CExprITokenPtr itoken)
 {
-  auto cstack = compile_->compileIToken(itoken);
+  return compileIToken(itoken, StringArray());
+}
 
-  if (getDebug())
-    std::cerr << "CTokenStack:" << cstack << "\n";
+CExprProgram
+CExpr::
+compileIToken(CExprITokenPtr itoken, const StringArray &args)
+{
+  auto program = compile_->compileIToken(itoken, args);
 
-  return cstack;
+  (void) peephole_->optimize(program);
+
+  if (getDebug()) {
+    std::cerr << "Program:" << program << "\n";
+
+    if (program.numFolded())
+      std::cerr << "Folded: " << program.numFolded() << "\n";
+
+    if (program.registerCode()) {
+      std::cerr << "Register Code:";
+      program.registerCode()->print(std::cerr, program);
+      std::cerr << "\n";
+    }
+  }
+
+  return program;
+}
+
+CExprCompiledExprP
+CExpr::
+compile(const std::string &str)
+{
+  auto compiledExpr = std::make_shared<CExprCompiledExpr>(this, str);
+
+  if (! compiledExpr->isValid())
+    return CExprCompiledExprP();
+
+  return compiledExpr;
 }
 
 bool
@@ -118,9 +192,9 @@ skipExpression(const std::string &line, uint &i)
 
 bool
 CExpr::
-executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values)
+executeProgram(const CExprProgram &program, CExprValueArray &values)
 {
-  if (! execute_->executeCTokenStack(stack, values))
+  if (! execute_->executeProgram(program, values))
     return false;
 
   if (getDebug()) {
@@ -135,9 +209,9 @@ executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values)
 
 bool
 CExpr::
-executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value)
+executeProgram(const CExprProgram &program, CExprValuePtr &value)
 {
-  if (! execute_->executeCTokenStack(stack, value))
+  if (! execute_->executeProgram(program, value))
     return false;
 
   if (getDebug() && value)
@@ -224,6 +298,56 @@ createStringVariable(const std::string &name, const std::string &str)
   return variableMgr_->createVariable(name, createStringValue(str));
 }
 
+CExprVariablePtr
+CExpr::
+createConstant(const std::string &name, CExprValuePtr value)
+{
+  auto variable = variableMgr_->createVariable(name, value);
+
+  variable->setConstant(true);
+
+  // constant values are substituted in compiled programs
+  functionMgr_->resetCompiled();
+
+  return variable;
+}
+
+CExprVariablePtr
+CExpr::
+bindRealVariable(const std::string &name, double *r)
+{
+  return bindVariable(name, CExprValueType::REAL, r);
+}
+
+CExprVariablePtr
+CExpr::
+bindIntegerVariable(const std::string &name, long *l)
+{
+  return bindVariable(name, CExprValueType::INTEGER, l);
+}
+
+CExprVariablePtr
+CExpr::
+bindStringVariable(const std::string &name, const char *s)
+{
+  // string memory is never written
+  return bindVariable(name, CExprValueType::STRING, const_cast<char *>(s));
+}
+
+CExprVariablePtr
+CExpr::
+bindVariable(const std::string &name, CExprValueType type, void *data)
+{
+  auto variable = getVariable(name);
+
+  if (! variable)
+    variable = variableMgr_->createVariable(name, CExprValuePtr());
+
+  variable->bind(this, type, data);
+
+  return variable;
+}
+
 CExprVariablePtr
 CExpr::
 createUserVariable(const std::string &name, CExprVariableObj *obj)
@@ -259,6 +383,13 @@ getFunctions(const std::string &name, Functions &functions)
   functionMgr_->getFunctions(name, functions);
 }
 
+CExprFunctionPtr
+CExpr::
+findFunction(const std::string &name, uint numArgs)
+{
+  return functionMgr_->findFunction(name, numArgs);
+}
+
 CExprFunctionPtr
 CExpr::
 addFunction(const std::string &name, const std::vector<std::string> &args, const std::string &proc)
@@ -273,6 +404,13 @@ addFunction(const std::string &name, const std::string &argsStr, CExprFunctionOb
   return functionMgr_->addObjFunction(name, argsStr, func);
 }
 
+CExprFunctionPtr
+CExpr::
+addTypedFunction(CExprFunction *function)
+{
+  return functionMgr_->addTypedFunction(function);
+}
+
 void
 CExpr::
 removeFunction(const std::string &name)
@@ -287,6 +425,13 @@ getFunctionNames(std::vector<std::string> &names) const
   functionMgr_->getFunctionNames(names);
 }
 
+uint
+CExpr::
+functionGeneration() const
+{
+  return functionMgr_->generation();
+}
+
 CExprTokenBaseP
 CExpr::
 getOperator(CExprOpType id)
@@ -310,28 +455,149 @@ CExprValuePtr
 CExpr::
 createBooleanValue(bool boolean)
 {
-  return CExprValuePtr(new CExprValue(CExprBooleanValue(boolean)));
+  return (boolean ? trueValue_ : falseValue_);
 }
 
 CExprValuePtr
 CExpr::
 createIntegerValue(long integer)
 {
-  return CExprValuePtr(new CExprValue(CExprIntegerValue(integer)));
+  if (integer >= minConstInteger && integer <= maxConstInteger)
+    return integerValues_[integer - minConstInteger];
+
+  auto *value = valuePool_->alloc();
+
+  *value = CExprIntegerValue(integer);
+
+  return CExprValuePtr(value);
 }
 
 CExprValuePtr
 CExpr::
 createRealValue(double real)
 {
-  return CExprValuePtr(new CExprValue(CExprRealValue(real)));
+  // keep -0.0 distinct from 0.0
+  if (real == 0.0 && ! std::signbit(real)) return realZeroValue_;
+  if (real == 1.0                        ) return realOneValue_;
+
+  auto *value = valuePool_->alloc();
+
+  *value = CExprRealValue(real);
+
+  return CExprValuePtr(value);
 }
 
 CExprValuePtr
 CExpr::
 createStringValue(const std::string &str)
 {
-  return CExprValuePtr(new CExprValue(CExprStringValue(str)));
+  auto *value = valuePool_->alloc();
+
+  *value = CExprStringValue(str);
+
+  return CExprValuePtr(value);
+}
+
+const CExprValuePool::Stats &
+CExpr::
+valuePoolStats() const
+{
+  return valuePool_->stats();
+}
+
+const CExprPeephole::Counts &
+CExpr::
+fusionCounts() const
+{
+  return peephole_->counts();
+}
+
+void
+CExpr::
+resetFusionCounts()
+{
+  peephole_->resetCounts();
+}
+
+void
+CExpr::
+printFusionCounts(std::ostream &os) const
+{
+  peephole_->printCounts(os);
+}
+
+void
+CExpr::
+setValuePoolMaxFree(uint n)
+{
+  valuePool_->setMaxFree(n);
+}
+
+void
+CExpr::
+setProgramCacheCapacity(uint maxEntries, size_t maxBytes)
+{
+  programCache_->setCapacity(maxEntries, maxBytes);
+}
+
+void
+CExpr::
+setProgramCacheNormalize(bool b)
+{
+  programCache_->setNormalize(b);
+}
+
+const CExprProgramCache::Stats &
+CExpr::
+programCacheStats() const
+{
+  return programCache_->stats();
+}
+
+void
+CExpr::
+clearProgramCache()
+{
+  programCache_->clear();
+}
+
+void
+CExpr::
+createConstantValues()
+{
+  falseValue_ = createConstantValue(CExprBooleanValue(false));
+  trueValue_  = createConstantValue(CExprBooleanValue(true ));
+
+  integerValues_.resize(maxConstInteger - minConstInteger + 1);
+
+  for (long i = minConstInteger; i <= maxConstInteger; ++i)
+    integerValues_[i - minConstInteger] = createConstantValue(CExprIntegerValue(i));
+
+  realZeroValue_ = createConstantValue(CExprRealValue(0.0));
+  realOneValue_  = createConstantValue(CExprRealValue(1.0));
+}
+
+CExprValuePtr
+CExpr::
+dupValue(const CExprValue &value)
+{
+  auto *value1 = valuePool_->alloc();
+
+  *value1 = value;
+
+  return CExprValuePtr(value1);
+}
+
+CExprValuePtr
+CExpr::
+createConstantValue(const CExprValue &value)
+{
+  // not pooled, engine holds reference for its lifetime
+  auto *value1 = new CExprValue(value);
+
+  value1->constant_ = true;
+
+  return CExprValuePtr(value1);
 }
 
 //------
@@ -14,7 +14,7 @@ execUnaryOp(CExpr *expr, CExprOpType op) const
 
 CExprValuePtr
 CExprBooleanValue::
-execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
+execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const
 {
   bool rboolean = false;
 
@@ -1,10 +1,23 @@
 #include <CExprI.h>
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
 
 class CExprCompileImpl {
+ public:
+  using ValueTypes     = std::vector<CExprValueType>;
+  using ExpressionKeys = std::map<const CExprIToken *, std::string>;
+  using KeyCounts      = std::map<std::string, uint>;
+  using Strings        = std::vector<std::string>;
+  using StringSet      = std::set<std::string>;
+  using ArgTemps       = std::map<std::string, uint>;
+
  public:
   CExprCompileImpl(CExpr *expr) : expr_(expr) { }
 
-  CExprTokenStack compileIToken(CExprITokenPtr itoken);
+  CExprProgram compileIToken(CExprITokenPtr itoken, const Strings &args);
 
   bool hasFunction(const std::string &name) const;
 
@@ -35,18 +48,72 @@ class CExprCompileImpl {
   void compileReal      (CExprITokenPtr itoken);
   void compileString    (CExprITokenPtr itoken);
   void compileValue     (CExprITokenPtr itoken);
+
+  bool getLValueName(CExprITokenPtr itoken, std::string &name) const;
 #if 0
   void compileITokenChildren(CExprITokenPtr itoken);
 #endif
 
-  void stackFunction  (CExprFunctionPtr function);
-  void stackDummyValue();
-  void stackCToken    (const CExprTokenBaseP &base);
+  bool isConstantVariable(const std::string &name, CExprVariablePtr &variable) const;
+
+  void stackValue      (const CExprValuePtr &value);
+  void stackVariable   (const std::string &name);
+  void stackAssign     (const std::string &name);
+  void stackPop        ();
+  void stackOperator   (CExprOpType op);
+  void stackPower      ();
+  void stackFunction   (CExprFunctionPtr function, uint numArgs);
+  bool inlineFunction  (CExprFunctionPtr function, uint numArgs);
+
+  CExprInstruction inlineVariable(const CExprProgram &body, const ArgTemps &argTemps,
+                                  CExprOpCode code, uint ind);
+  void stackDummyValue ();
+  uint stackJump       (CExprOpCode code, CExprOpType op=CExprOpType::UNKNOWN);
+  void stackInstruction(const CExprInstruction &instruction);
+
+  void stackShortCircuitResult(uint lhsJump, uint rhsJump, bool value);
+
+  void foldConstants(uint numOperands);
+
+  void findCommonExpressions(CExprITokenPtr itoken);
+
+  bool expressionKey(CExprITokenPtr itoken, ExpressionKeys &keys, KeyCounts &counts,
+                     std::string &key, bool &pure) const;
+
+  void findExpressionUses(CExprITokenPtr itoken, const ExpressionKeys &keys,
+                          Strings &calculated, StringSet &loaded) const;
+
+  bool loadCommonExpression (CExprITokenPtr itoken);
+  void storeCommonExpression(CExprITokenPtr itoken);
+
+  void inferTypes();
+
+  static void mergeTypes(ValueTypes &types, const ValueTypes &types1);
+
+  static CExprOpCode    untypedOpCode (CExprOpCode code);
+  static CExprOpCode    typedOpCode   (CExprOpCode code, CExprOpType op,
+                                       CExprValueType type1, CExprValueType type2);
+  static CExprValueType resultType    (CExprOpCode code, CExprOpType op,
+                                       CExprValueType type1, CExprValueType type2);
 
  private:
-  CExpr*          expr_ { 0 };
-  CExprTokenStack tokenStack_;
-  CExprErrorData  errorData_;
+  using CExprExecuteP = std::shared_ptr<CExprExecute>;
+
+  // temporary holding value of common subexpression
+  struct Temp {
+    std::string key;
+    uint        ind { 0 };
+  };
+
+  using Temps = std::vector<Temp>;
+
+  CExpr*         expr_ { 0 };
+  CExprProgram   program_;
+  CExprErrorData errorData_;
+  CExprExecuteP  foldExecute_;
+  ExpressionKeys commonKeys_;
+  Temps          temps_;
+  StringSet      args_;
 };
 
 //------
@@ -63,11 +130,11 @@ CExprCompile::
 {
 }
 
-CExprTokenStack
+CExprProgram
 CExprCompile::
-compileIToken(CExprITokenPtr itoken)
+compileIToken(CExprITokenPtr itoken, const Args &args)
 {
-  return impl_->compileIToken(itoken);
+  return impl_->compileIToken(itoken, args);
 }
 
 bool
@@ -79,25 +146,40 @@ hasFunction(const std::string &name) const
 
 //------
 
-CExprTokenStack
+CExprProgram
 CExprCompileImpl::
-compileIToken(CExprITokenPtr itoken)
+compileIToken(CExprITokenPtr itoken, const Strings &args)
 {
-  tokenStack_.clear();
+  program_.clear();
 
   if (! itoken)
-    return tokenStack_;
+    return program_;
 
   errorData_.setLastError("");
 
+  args_ = StringSet(args.begin(), args.end());
+
+  findCommonExpressions(itoken);
+
   compileIToken1(itoken);
 
+  commonKeys_.clear();
+  temps_     .clear();
+  args_      .clear();
+
   if (errorData_.isError()) {
     expr_->errorMsg(errorData_.getLastError());
-    return CExprTokenStack();
+    return CExprProgram();
   }
 
-  return tokenStack_;
+  inferTypes();
+
+  program_.bindVariables(expr_);
+
+  if (expr_->getRegisterVM())
+    (void) program_.buildRegisterCode();
+
+  return program_;
 }
 
 void
@@ -225,9 +307,8 @@ compileExpression(CExprITokenPtr itoken)
   if      (num_children == 3) {
     compileExpression(itoken->getChild(0));
 
+    // values of both expressions are left on the stack
     compileAssignmentExpression(itoken->getChild(2));
-
-    stackCToken(itoken->getChild(1)->base());
   }
   else if (num_children == 1)
     compileAssignmentExpression(itoken->getChild(0));
@@ -255,7 +336,12 @@ compileAssignmentExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
-    compileUnaryExpression(itoken->getChild(0));
+    std::string name;
+
+    if (! getLValueName(itoken->getChild(0), name)) {
+      errorData_.setLastError("Non lvalue for assignment");
+      return;
+    }
 
     auto itoken1 = itoken->getChild(1);
 
@@ -271,7 +357,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::TIMES));
+        stackOperator(CExprOpType::TIMES);
 
         break;
       case CExprOpType::DIVIDE_EQUALS:
@@ -279,7 +365,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::DIVIDE));
+        stackOperator(CExprOpType::DIVIDE);
 
         break;
       case CExprOpType::MODULUS_EQUALS:
@@ -287,7 +373,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::MODULUS));
+        stackOperator(CExprOpType::MODULUS);
 
         break;
       case CExprOpType::PLUS_EQUALS:
@@ -295,7 +381,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::PLUS));
+        stackOperator(CExprOpType::PLUS);
 
         break;
       case CExprOpType::MINUS_EQUALS:
@@ -303,7 +389,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::MINUS));
+        stackOperator(CExprOpType::MINUS);
 
         break;
       case CExprOpType::BIT_LSHIFT_EQUALS:
@@ -311,7 +397,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::BIT_LSHIFT));
+        stackOperator(CExprOpType::BIT_LSHIFT);
 
         break;
       case CExprOpType::BIT_RSHIFT_EQUALS:
@@ -319,7 +405,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::BIT_RSHIFT));
+        stackOperator(CExprOpType::BIT_RSHIFT);
 
         break;
       case CExprOpType::BIT_AND_EQUALS:
@@ -327,7 +413,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::BIT_AND));
+        stackOperator(CExprOpType::BIT_AND);
 
         break;
       case CExprOpType::BIT_XOR_EQUALS:
@@ -335,7 +421,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::BIT_XOR));
+        stackOperator(CExprOpType::BIT_XOR);
 
         break;
       case CExprOpType::BIT_OR_EQUALS:
@@ -343,7 +429,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
 
         compileAssignmentExpression(itoken->getChild(2));
 
-        stackCToken(expr_->getOperator(CExprOpType::BIT_OR));
+        stackOperator(CExprOpType::BIT_OR);
 
         break;
       default:
@@ -351,7 +437,7 @@ compileAssignmentExpression(CExprITokenPtr itoken)
         break;
     }
 
-    stackCToken(expr_->getOperator(CExprOpType::EQUALS));
+    stackAssign(name);
   }
   else
     compileConditionalExpression(itoken->getChild(0));
@@ -372,28 +458,32 @@ compileConditionalExpression(CExprITokenPtr itoken)
   if (num_children == 5) {
     // 0 boolean, 2 = lhs, 4 = rhs
 
-    // stack lhs expression
-    stackCToken(expr_->getOperator(CExprOpType::START_BLOCK));
+    // <boolean> jump_if_false(rhs) <lhs> jump(end) rhs: <rhs> end:
+    compileLogicalOrExpression(itoken->getChild(0));
+
+    uint falseJump = stackJump(CExprOpCode::JUMP_IF_FALSE, CExprOpType::QUESTION);
 
-    compileExpression(itoken->getChild(2));
+    int depth = program_.depth();
 
-    stackCToken(expr_->getOperator(CExprOpType::END_BLOCK));
+    // common subexpressions calculated in a branch are only available in that branch
+    uint numTemps = uint(temps_.size());
 
-    //---
+    compileExpression(itoken->getChild(2));
 
-    // stack lhs expression
-    stackCToken(expr_->getOperator(CExprOpType::START_BLOCK));
+    temps_.resize(numTemps);
 
-    compileConditionalExpression(itoken->getChild(4));
+    uint endJump = stackJump(CExprOpCode::JUMP);
 
-    stackCToken(expr_->getOperator(CExprOpType::END_BLOCK));
+    // rhs starts with same stack as lhs
+    program_.setDepth(depth);
 
-    //---
+    program_.setJumpTarget(falseJump, program_.numInstructions());
 
-    // stack conditional
-    compileLogicalOrExpression(itoken->getChild(0));
+    compileConditionalExpression(itoken->getChild(4));
 
-    stackCToken(expr_->getOperator(CExprOpType::QUESTION));
+    temps_.resize(numTemps);
+
+    program_.setJumpTarget(endJump, program_.numInstructions());
   }
   else
     compileLogicalOrExpression(itoken->getChild(0));
@@ -411,11 +501,21 @@ compileLogicalOrExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    // rhs only evaluated if lhs is false
+    // <lhs> jump_if_true(T) <rhs> jump_if_true(T) push(false) jump(end) T: push(true) end:
     compileLogicalOrExpression(itoken->getChild(0));
 
+    uint lhsJump = stackJump(CExprOpCode::JUMP_IF_TRUE, CExprOpType::LOGICAL_OR);
+
+    uint numTemps = uint(temps_.size());
+
     compileLogicalAndExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::LOGICAL_OR));
+    temps_.resize(numTemps);
+
+    uint rhsJump = stackJump(CExprOpCode::JUMP_IF_TRUE, CExprOpType::LOGICAL_OR);
+
+    stackShortCircuitResult(lhsJump, rhsJump, true);
   }
   else
     compileLogicalAndExpression(itoken->getChild(0));
@@ -433,11 +533,21 @@ compileLogicalAndExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    // rhs only evaluated if lhs is true
+    // <lhs> jump_if_false(F) <rhs> jump_if_false(F) push(true) jump(end) F: push(false) end:
     compileLogicalAndExpression(itoken->getChild(0));
 
+    uint lhsJump = stackJump(CExprOpCode::JUMP_IF_FALSE, CExprOpType::LOGICAL_AND);
+
+    uint numTemps = uint(temps_.size());
+
     compileInclusiveOrExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::LOGICAL_AND));
+    temps_.resize(numTemps);
+
+    uint rhsJump = stackJump(CExprOpCode::JUMP_IF_FALSE, CExprOpType::LOGICAL_AND);
+
+    stackShortCircuitResult(lhsJump, rhsJump, false);
   }
   else
     compileInclusiveOrExpression(itoken->getChild(0));
@@ -455,11 +565,16 @@ compileInclusiveOrExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileInclusiveOrExpression(itoken->getChild(0));
 
     compileExclusiveOrExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::BIT_OR));
+    stackOperator(CExprOpType::BIT_OR);
+
+    storeCommonExpression(itoken);
   }
   else
     compileExclusiveOrExpression(itoken->getChild(0));
@@ -477,11 +592,16 @@ compileExclusiveOrExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileExclusiveOrExpression(itoken->getChild(0));
 
     compileAndExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::BIT_XOR));
+    stackOperator(CExprOpType::BIT_XOR);
+
+    storeCommonExpression(itoken);
   }
   else
     compileAndExpression(itoken->getChild(0));
@@ -499,11 +619,16 @@ compileAndExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileAndExpression(itoken->getChild(0));
 
     compileEqualityExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::BIT_AND));
+    stackOperator(CExprOpType::BIT_AND);
+
+    storeCommonExpression(itoken);
   }
   else
     compileEqualityExpression(itoken->getChild(0));
@@ -523,6 +648,9 @@ compileEqualityExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     auto itoken1 = itoken->getChild(1);
 
     auto op = itoken1->getOperator();
@@ -532,24 +660,26 @@ compileEqualityExpression(CExprITokenPtr itoken)
 
       compileRelationalExpression(itoken->getChild(2));
 
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     }
     else if (op == CExprOpType::NOT_EQUAL) {
       compileEqualityExpression(itoken->getChild(0));
 
       compileRelationalExpression(itoken->getChild(2));
 
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     }
     else if (op == CExprOpType::APPROX_EQUAL) {
       compileEqualityExpression(itoken->getChild(0));
 
       compileRelationalExpression(itoken->getChild(2));
 
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     }
     else
       assert(false);
+
+    storeCommonExpression(itoken);
   }
   else
     compileRelationalExpression(itoken->getChild(0));
@@ -570,13 +700,18 @@ compileRelationalExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileRelationalExpression(itoken->getChild(0));
 
     compileShiftExpression(itoken->getChild(2));
 
     auto itoken1 = itoken->getChild(1);
 
-    stackCToken(itoken1->base());
+    stackOperator(itoken1->getOperator());
+
+    storeCommonExpression(itoken);
   }
   else
     compileShiftExpression(itoken->getChild(0));
@@ -595,6 +730,9 @@ compileShiftExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileShiftExpression(itoken->getChild(0));
 
     compileAdditiveExpression(itoken->getChild(2));
@@ -604,11 +742,13 @@ compileShiftExpression(CExprITokenPtr itoken)
     auto op = itoken1->getOperator();
 
     if      (op == CExprOpType::BIT_LSHIFT)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else if (op == CExprOpType::BIT_RSHIFT)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else
       assert(false);
+
+    storeCommonExpression(itoken);
   }
   else
     compileAdditiveExpression(itoken->getChild(0));
@@ -627,6 +767,9 @@ compileAdditiveExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileAdditiveExpression(itoken->getChild(0));
 
     compileMultiplicativeExpression(itoken->getChild(2));
@@ -636,11 +779,13 @@ compileAdditiveExpression(CExprITokenPtr itoken)
     auto op = itoken1->getOperator();
 
     if      (op == CExprOpType::PLUS)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else if (op == CExprOpType::MINUS)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else
       assert(false);
+
+    storeCommonExpression(itoken);
   }
   else
     compileMultiplicativeExpression(itoken->getChild(0));
@@ -660,6 +805,9 @@ compileMultiplicativeExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compileMultiplicativeExpression(itoken->getChild(0));
 
     compileUnaryExpression(itoken->getChild(2));
@@ -669,13 +817,15 @@ compileMultiplicativeExpression(CExprITokenPtr itoken)
     auto op = itoken1->getOperator();
 
     if      (op == CExprOpType::TIMES)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else if (op == CExprOpType::DIVIDE)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else if (op == CExprOpType::MODULUS)
-      stackCToken(itoken1->base());
+      stackOperator(itoken1->getOperator());
     else
       assert(false);
+
+    storeCommonExpression(itoken);
   }
   else
     compileUnaryExpression(itoken->getChild(0));
@@ -698,52 +848,67 @@ compileUnaryExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 2) {
+    if (loadCommonExpression(itoken))
+      return;
+
     auto itoken0 = itoken->getChild(0);
 
     if (itoken0->base()) {
       auto op = itoken0->getOperator();
 
       switch (op) {
-        case CExprOpType::INCREMENT:
-          compileUnaryExpression(itoken->getChild(1));
+        case CExprOpType::INCREMENT: {
+          std::string name;
+
+          if (! getLValueName(itoken->getChild(1), name)) {
+            errorData_.setLastError("Non lvalue for increment");
+            return;
+          }
 
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(expr_->getOperator(CExprOpType::PLUS));
-          stackCToken(expr_->getOperator(CExprOpType::EQUALS));
+          stackOperator(CExprOpType::INCREMENT);
+          stackAssign(name);
 
           break;
-        case CExprOpType::DECREMENT:
-          compileUnaryExpression(itoken->getChild(1));
+        }
+        case CExprOpType::DECREMENT: {
+          std::string name;
+
+          if (! getLValueName(itoken->getChild(1), name)) {
+            errorData_.setLastError("Non lvalue for decrement");
+            return;
+          }
 
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(expr_->getOperator(CExprOpType::MINUS));
-          stackCToken(expr_->getOperator(CExprOpType::EQUALS));
+          stackOperator(CExprOpType::DECREMENT);
+          stackAssign(name);
 
           break;
+        }
         case CExprOpType::PLUS:
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(expr_->getOperator(CExprOpType::UNARY_PLUS));
+          stackOperator(CExprOpType::UNARY_PLUS);
 
           break;
         case CExprOpType::MINUS:
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(expr_->getOperator(CExprOpType::UNARY_MINUS));
+          stackOperator(CExprOpType::UNARY_MINUS);
 
           break;
         case CExprOpType::BIT_NOT:
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(itoken0->base());
+          stackOperator(itoken0->getOperator());
 
           break;
         case CExprOpType::LOGICAL_NOT:
           compileUnaryExpression(itoken->getChild(1));
 
-          stackCToken(itoken0->base());
+          stackOperator(itoken0->getOperator());
 
           break;
         default:
@@ -754,6 +919,8 @@ compileUnaryExpression(CExprITokenPtr itoken)
     else {
       assert(false);
     }
+
+    storeCommonExpression(itoken);
   }
   else
     compilePowerExpression(itoken->getChild(0));
@@ -771,11 +938,16 @@ compilePowerExpression(CExprITokenPtr itoken)
   uint num_children = itoken->getNumChildren();
 
   if (num_children == 3) {
+    if (loadCommonExpression(itoken))
+      return;
+
     compilePostfixExpression(itoken->getChild(0));
 
     compilePowerExpression(itoken->getChild(2));
 
-    stackCToken(expr_->getOperator(CExprOpType::POWER));
+    stackPower();
+
+    storeCommonExpression(itoken);
   }
   else
     compilePostfixExpression(itoken->getChild(0));
@@ -806,7 +978,8 @@ compilePostfixExpression(CExprITokenPtr itoken)
   auto op = itoken1->getOperator();
 
   if      (op == CExprOpType::OPEN_RBRACKET) {
-    stackCToken(itoken1->base());
+    if (loadCommonExpression(itoken))
+      return;
 
     uint num_args = 0;
 
@@ -821,23 +994,7 @@ compilePostfixExpression(CExprITokenPtr itoken)
 
     const auto &identifier = itoken00->getIdentifier();
 
-    CExprFunctionMgr::Functions functions;
-
-    expr_->getFunctions(identifier, functions);
-
-    CExprFunctionPtr function;
-
-    for (auto &function1 : functions) {
-      if (! function1)
-        continue;
-
-      function = function1;
-
-      auto function_num_args = function1->numArgs();
-
-      if (function_num_args == num_args)
-        break;
-    }
+    auto function = expr_->findFunction(identifier, num_args);
 
     if (! function) {
       errorData_.setLastError("Invalid Function '" + identifier + "'");
@@ -868,21 +1025,41 @@ compilePostfixExpression(CExprITokenPtr itoken)
       }
     }
 
-    stackFunction(function);
+    stackFunction(function, num_args);
+
+    storeCommonExpression(itoken);
   }
   else if (op == CExprOpType::INCREMENT) {
+    std::string name;
+
+    if (! getLValueName(itoken->getChild(0), name)) {
+      errorData_.setLastError("Non lvalue for increment");
+      return;
+    }
+
+    // result is value before update
+    compilePostfixExpression(itoken->getChild(0));
     compilePostfixExpression(itoken->getChild(0));
-    compilePostfixExpression(itoken->getChild(0)); // dup value
 
-    stackCToken(expr_->getOperator(CExprOpType::EQUALS));
-    stackCToken(expr_->getOperator(CExprOpType::PLUS));
+    stackOperator(CExprOpType::INCREMENT);
+    stackAssign(name);
+    stackPop();
   }
   else if (op == CExprOpType::DECREMENT) {
+    std::string name;
+
+    if (! getLValueName(itoken->getChild(0), name)) {
+      errorData_.setLastError("Non lvalue for decrement");
+      return;
+    }
+
+    // result is value before update
+    compilePostfixExpression(itoken->getChild(0));
     compilePostfixExpression(itoken->getChild(0));
-    compilePostfixExpression(itoken->getChild(0)); // dup value
 
-    stackCToken(expr_->getOperator(CExprOpType::EQUALS));
-    stackCToken(expr_->getOperator(CExprOpType::MINUS));
+    stackOperator(CExprOpType::DECREMENT);
+    stackAssign(name);
+    stackPop();
   }
 }
 
@@ -952,54 +1129,67 @@ void
 CExprCompileImpl::
 compileIdentifier(CExprITokenPtr itoken)
 {
-  stackCToken(itoken->base());
+  stackVariable(itoken->getIdentifier());
 }
 
 void
 CExprCompileImpl::
 compileOperator(CExprITokenPtr itoken)
 {
-  stackCToken(itoken->base());
+  stackOperator(itoken->getOperator());
 }
 
 void
 CExprCompileImpl::
 compileInteger(CExprITokenPtr itoken)
 {
-  auto value = expr_->createIntegerValue(itoken->getInteger());
-
-  CExprTokenBaseP base(CExprTokenMgrInst->createValueToken(value));
-
-  stackCToken(base);
+  stackValue(expr_->createIntegerValue(itoken->getInteger()));
 }
 
 void
 CExprCompileImpl::
 compileReal(CExprITokenPtr itoken)
 {
-  auto value = expr_->createRealValue(itoken->getReal());
-
-  CExprTokenBaseP base(CExprTokenMgrInst->createValueToken(value));
-
-  stackCToken(base);
+  stackValue(expr_->createRealValue(itoken->getReal()));
 }
 
 void
 CExprCompileImpl::
 compileString(CExprITokenPtr itoken)
 {
-  auto value = expr_->createStringValue(itoken->getString());
-
-  CExprTokenBaseP base(CExprTokenMgrInst->createValueToken(value));
-
-  stackCToken(base);
+  stackValue(expr_->createStringValue(itoken->getString()));
 }
 
 void
 CExprCompileImpl::
 compileValue(CExprITokenPtr itoken)
 {
-  stackCToken(itoken->base());
+  stackValue(itoken->base()->getValue());
+}
+
+// get variable name of assignment target (identifier or bracketed identifier)
+bool
+CExprCompileImpl::
+getLValueName(CExprITokenPtr itoken, std::string &name) const
+{
+  while (itoken->getIType() != CExprITokenType::TOKEN_TYPE) {
+    uint num_children = itoken->getNumChildren();
+
+    if      (num_children == 1)
+      itoken = itoken->getChild(0);
+    else if (num_children == 3 &&
+             itoken->getIType() == CExprITokenType::PRIMARY_EXPRESSION)
+      itoken = itoken->getChild(1);
+    else
+      return false;
+  }
+
+  if (itoken->getType() != CExprTokenType::IDENTIFIER)
+    return false;
+
+  name = itoken->getIdentifier();
+
+  return true;
 }
 
 #if 0
@@ -1016,32 +1206,978 @@ compileITokenChildren(CExprITokenPtr itoken)
 
 void
 CExprCompileImpl::
-stackFunction(CExprFunctionPtr function)
+stackValue(const CExprValuePtr &value)
 {
-  CExprTokenBaseP base(CExprTokenMgrInst->createFunctionToken(function));
+  stackInstruction(CExprInstruction(CExprOpCode::PUSH_VALUE, CExprOpType::UNKNOWN,
+                                    program_.addValue(value)));
+}
+
+// variable is constant (args of user function body are not constant)
+bool
+CExprCompileImpl::
+isConstantVariable(const std::string &name, CExprVariablePtr &variable) const
+{
+  if (args_.find(name) != args_.end())
+    return false;
+
+  variable = expr_->getVariable(name);
 
-  stackCToken(base);
+  return (variable && variable->isConstant());
 }
 
 void
 CExprCompileImpl::
-stackDummyValue()
+stackVariable(const std::string &name)
+{
+  CExprVariablePtr variable;
+
+  if (isConstantVariable(name, variable) && variable->getValue()) {
+    stackValue(variable->getValue());
+
+    program_.setNumFolded(program_.numFolded() + 1);
+
+    return;
+  }
+
+  stackInstruction(CExprInstruction(CExprOpCode::LOAD_VAR, CExprOpType::UNKNOWN,
+                                    program_.addIdentifier(name)));
+}
+
+void
+CExprCompileImpl::
+stackAssign(const std::string &name)
+{
+  CExprVariablePtr variable;
+
+  if (isConstantVariable(name, variable)) {
+    errorData_.setLastError("Cannot assign to constant '" + name + "'");
+    return;
+  }
+
+  stackInstruction(CExprInstruction(CExprOpCode::STORE_VAR, CExprOpType::EQUALS,
+                                    program_.addIdentifier(name)));
+}
+
+void
+CExprCompileImpl::
+stackPop()
+{
+  stackInstruction(CExprInstruction(CExprOpCode::POP));
+}
+
+void
+CExprCompileImpl::
+stackOperator(CExprOpType op)
+{
+  CExprOpCode code = CExprOpCode::NOP;
+
+  switch (op) {
+    case CExprOpType::UNARY_PLUS:
+    case CExprOpType::UNARY_MINUS:
+    case CExprOpType::INCREMENT:
+    case CExprOpType::DECREMENT:
+      code = CExprOpCode::UNARY_OP;
+      break;
+    case CExprOpType::LOGICAL_NOT:
+      code = CExprOpCode::LOGICAL_UNARY_OP;
+      break;
+    case CExprOpType::BIT_NOT:
+      code = CExprOpCode::BITWISE_UNARY_OP;
+      break;
+    case CExprOpType::POWER:
+    case CExprOpType::TIMES:
+    case CExprOpType::DIVIDE:
+    case CExprOpType::MODULUS:
+    case CExprOpType::PLUS:
+    case CExprOpType::MINUS:
+    case CExprOpType::LESS:
+    case CExprOpType::LESS_EQUAL:
+    case CExprOpType::GREATER:
+    case CExprOpType::GREATER_EQUAL:
+    case CExprOpType::EQUAL:
+    case CExprOpType::NOT_EQUAL:
+    case CExprOpType::APPROX_EQUAL:
+      code = CExprOpCode::BINARY_OP;
+      break;
+    case CExprOpType::LOGICAL_AND:
+    case CExprOpType::LOGICAL_OR:
+      code = CExprOpCode::LOGICAL_BINARY_OP;
+      break;
+    case CExprOpType::BIT_LSHIFT:
+    case CExprOpType::BIT_RSHIFT:
+    case CExprOpType::BIT_AND:
+    case CExprOpType::BIT_XOR:
+    case CExprOpType::BIT_OR:
+      code = CExprOpCode::BITWISE_BINARY_OP;
+      break;
+    default:
+      errorData_.setLastError("Invalid operator '" + expr_->getOperatorName(op) + "'");
+      return;
+  }
+
+  stackInstruction(CExprInstruction(code, op));
+
+  if (code == CExprOpCode::UNARY_OP || code == CExprOpCode::LOGICAL_UNARY_OP ||
+      code == CExprOpCode::BITWISE_UNARY_OP)
+    foldConstants(1);
+  else
+    foldConstants(2);
+}
+
+// power operator. A small constant integer exponent is replaced by an instruction
+// which raises the value to the power by repeated squaring
+void
+CExprCompileImpl::
+stackPower()
+{
+  stackOperator(CExprOpType::POWER);
+
+  uint n = program_.numInstructions();
+
+  if (n < 2 || n - 2 < program_.lastJumpTarget())
+    return;
+
+  const auto &instruction1 = program_.instruction(n - 2);
+  const auto &instruction2 = program_.instruction(n - 1);
+
+  // constant operands are folded
+  if (instruction2.code != CExprOpCode::BINARY_OP || instruction1.code != CExprOpCode::PUSH_VALUE)
+    return;
+
+  const auto &value = program_.value(instruction1.arg1);
+
+  if (! value->isType(CExprValueType::INTEGER))
+    return;
+
+  long exponent = value->integer();
+
+  if (exponent < 0 || exponent > 64)
+    return;
+
+  program_.removeLastInstruction();
+  program_.removeLastInstruction();
+
+  stackInstruction(CExprInstruction(CExprOpCode::POWER_INT, CExprOpType::POWER, uint(exponent)));
+}
+
+// replace operator with constant operands by its result. The operator is run by a
+// separate executor so values have the same semantics as at run time and operators
+// which fail are left to report their error when executed
+void
+CExprCompileImpl::
+foldConstants(uint numOperands)
+{
+  uint n = program_.numInstructions();
+
+  if (n < numOperands + 1)
+    return;
+
+  uint start = n - numOperands - 1;
+
+  if (start < program_.lastJumpTarget())
+    return;
+
+  CExprProgram program;
+
+  for (uint i = start; i < n - 1; ++i) {
+    const auto &instruction = program_.instruction(i);
+
+    if (instruction.code != CExprOpCode::PUSH_VALUE)
+      return;
+
+    program.addInstruction(CExprInstruction(CExprOpCode::PUSH_VALUE, CExprOpType::UNKNOWN,
+                                            program.addValue(program_.value(instruction.arg1))));
+  }
+
+  program.addInstruction(program_.instruction(n - 1));
+
+  if (! foldExecute_)
+    foldExecute_ = std::make_shared<CExprExecute>(expr_);
+
+  CExprValuePtr value;
+
+  if (! foldExecute_->executeProgram(program, value) || ! value)
+    return;
+
+  for (uint i = start; i < n; ++i)
+    program_.removeLastInstruction();
+
+  stackValue(value);
+
+  program_.setNumFolded(program_.numFolded() + 1);
+}
+
+void
+CExprCompileImpl::
+stackFunction(CExprFunctionPtr function, uint numArgs)
+{
+  if (inlineFunction(function, numArgs))
+    return;
+
+  stackInstruction(CExprInstruction(CExprOpCode::CALL, CExprOpType::UNKNOWN,
+                                    program_.addFunction(function), numArgs));
+}
+
+// Replace call of user function by its compiled body with the arguments stored in
+// temporaries. Recursive functions (body being compiled), bodies larger than the
+// inline size and bodies which call non-builtin functions (which can read the
+// arguments as variables) are called.
+bool
+CExprCompileImpl::
+inlineFunction(CExprFunctionPtr function, uint numArgs)
 {
-  CExprTokenBaseP base(CExprTokenMgrInst->createValueToken(CExprValuePtr()));
+  uint maxSize = expr_->getMaxInlineSize();
+
+  if (maxSize == 0 || ! function->isUser())
+    return false;
+
+  auto *userFunction = static_cast<CExprUserFunction *>(function.get());
+
+  if (userFunction->numArgs() != numArgs || ! userFunction->compile(expr_))
+    return false;
+
+  const auto &body = userFunction->program();
+
+  if (body.empty() || body.depth() != 1)
+    return false;
+
+  // size after superinstructions are expanded
+  uint numInstructions = body.numInstructions();
+
+  std::vector<uint> newIndex(numInstructions + 1, 0);
+
+  uint size = 0;
+
+  for (uint i = 0; i < numInstructions; ++i) {
+    const auto &instruction = body.instruction(i);
+
+    if (instruction.code == CExprOpCode::CALL && ! body.function(instruction.arg1)->isBuiltin())
+      return false;
+
+    newIndex[i] = size;
+
+    switch (instruction.code) {
+      case CExprOpCode::BINARY_VAR_CONST:
+      case CExprOpCode::BINARY_VAR_VAR:
+        size += 3;
+        break;
+      case CExprOpCode::BINARY_JUMP_IF_FALSE:
+      case CExprOpCode::BINARY_JUMP_IF_TRUE:
+        size += 2;
+        break;
+      default:
+        size += 1;
+        break;
+    }
+  }
+
+  if (size > maxSize)
+    return false;
+
+  newIndex[numInstructions] = size;
+
+  //---
+
+  // pop arguments into temporaries (last duplicate argument name is used)
+  const auto &args = userFunction->args();
+
+  ArgTemps argTemps;
+
+  std::vector<uint> temps(numArgs);
+
+  for (uint i = 0; i < numArgs; ++i) {
+    temps[i] = program_.addTemp();
+
+    argTemps[args[i]] = temps[i];
+  }
+
+  int depth = program_.depth();
+
+  for (uint i = numArgs; i > 0; --i) {
+    stackInstruction(CExprInstruction(CExprOpCode::STORE_TEMP, CExprOpType::UNKNOWN,
+                                      temps[i - 1]));
+    stackPop();
+  }
+
+  // body temporaries follow argument temporaries
+  uint tempBase = program_.numTemps();
+
+  for (uint i = 0; i < body.numTemps(); ++i)
+    (void) program_.addTemp();
+
+  uint start = program_.numInstructions();
+
+  //---
+
+  // typed operators are inferred again for caller's argument types
+  for (uint i = 0; i < numInstructions; ++i) {
+    const auto &instruction = body.instruction(i);
+
+    switch (instruction.code) {
+      case CExprOpCode::PUSH_VALUE:
+        stackValue(body.value(instruction.arg1));
+        break;
+      case CExprOpCode::LOAD_VAR:
+      case CExprOpCode::STORE_VAR:
+        stackInstruction(inlineVariable(body, argTemps, instruction.code, instruction.arg1));
+        break;
+      case CExprOpCode::STORE_TEMP:
+      case CExprOpCode::LOAD_TEMP:
+        stackInstruction(CExprInstruction(instruction.code, CExprOpType::UNKNOWN,
+                                          tempBase + instruction.arg1));
+        break;
+      case CExprOpCode::CALL:
+        stackInstruction(CExprInstruction(CExprOpCode::CALL, CExprOpType::UNKNOWN,
+                                          program_.addFunction(body.function(instruction.arg1)),
+                                          instruction.arg2));
+        break;
+      case CExprOpCode::JUMP:
+      case CExprOpCode::JUMP_IF_FALSE:
+      case CExprOpCode::JUMP_IF_TRUE: {
+        uint ind = stackJump(instruction.code, instruction.op);
+
+        program_.setJumpTarget(ind, start + newIndex[instruction.arg1]);
+
+        break;
+      }
+      case CExprOpCode::BINARY_VAR_CONST:
+      case CExprOpCode::BINARY_VAR_VAR:
+        stackInstruction(inlineVariable(body, argTemps, CExprOpCode::LOAD_VAR, instruction.arg1));
+
+        if (instruction.code == CExprOpCode::BINARY_VAR_CONST)
+          stackValue(body.value(instruction.arg2));
+        else
+          stackInstruction(inlineVariable(body, argTemps, CExprOpCode::LOAD_VAR, instruction.arg2));
+
+        stackInstruction(CExprInstruction(untypedOpCode(instruction.fused), instruction.op));
+
+        break;
+      case CExprOpCode::BINARY_JUMP_IF_FALSE:
+      case CExprOpCode::BINARY_JUMP_IF_TRUE: {
+        stackInstruction(CExprInstruction(untypedOpCode(instruction.fused), instruction.op));
+
+        uint ind = stackJump(instruction.code == CExprOpCode::BINARY_JUMP_IF_FALSE ?
+          CExprOpCode::JUMP_IF_FALSE : CExprOpCode::JUMP_IF_TRUE, CExprOpType(instruction.arg2));
+
+        program_.setJumpTarget(ind, start + newIndex[instruction.arg1]);
+
+        break;
+      }
+      default:
+        stackInstruction(CExprInstruction(untypedOpCode(instruction.code), instruction.op,
+                                          instruction.arg1, instruction.arg2));
+        break;
+    }
+  }
+
+  // body leaves result in place of arguments
+  program_.setDepth(depth - int(numArgs) + 1);
+
+  return true;
+}
+
+// load or store of inlined body variable (temporary for argument)
+CExprInstruction
+CExprCompileImpl::
+inlineVariable(const CExprProgram &body, const ArgTemps &argTemps, CExprOpCode code, uint ind)
+{
+  const auto &name = body.identifier(ind);
+
+  auto p = argTemps.find(name);
+
+  if (p != argTemps.end()) {
+    auto code1 = (code == CExprOpCode::LOAD_VAR ? CExprOpCode::LOAD_TEMP : CExprOpCode::STORE_TEMP);
+
+    return CExprInstruction(code1, CExprOpType::UNKNOWN, (*p).second);
+  }
+
+  return CExprInstruction(code, CExprOpType::UNKNOWN, program_.addIdentifier(name));
+}
+
+void
+CExprCompileImpl::
+stackDummyValue()
+{
+  stackInstruction(CExprInstruction(CExprOpCode::PUSH_NULL));
+}
+
+// Find pure subexpressions which occur more than once in the expression. Only
+// operators and function calls which depend on a variable or function value are
+// considered (constant subexpressions are folded). Expressions with side effects
+// (assignment, increment, decrement or impure function) can change values between
+// uses so have no common subexpressions.
+void
+CExprCompileImpl::
+findCommonExpressions(CExprITokenPtr itoken)
+{
+  commonKeys_.clear();
+  temps_     .clear();
+
+  ExpressionKeys keys;
+  KeyCounts      counts;
+  std::string    key;
+  bool           pure = true;
+
+  (void) expressionKey(itoken, keys, counts, key, pure);
+
+  if (! pure)
+    return;
+
+  // only keep keys of repeated subexpressions
+  ExpressionKeys repeatKeys;
+
+  for (const auto &pkey : keys) {
+    if (counts[pkey.second] > 1)
+      repeatKeys[pkey.first] = pkey.second;
+  }
+
+  if (repeatKeys.empty())
+    return;
+
+  // only use temporary if value is loaded (subexpressions of loaded values and
+  // values calculated in different branches are not)
+  Strings   calculated;
+  StringSet loaded;
+
+  findExpressionUses(itoken, repeatKeys, calculated, loaded);
+
+  for (const auto &pkey : repeatKeys) {
+    if (loaded.find(pkey.second) != loaded.end())
+      commonKeys_[pkey.first] = pkey.second;
+  }
+}
+
+// find repeated subexpressions which can be loaded from value calculated earlier.
+// Follows compile order and scope of temporaries in conditional branches
+void
+CExprCompileImpl::
+findExpressionUses(CExprITokenPtr itoken, const ExpressionKeys &keys,
+                   Strings &calculated, StringSet &loaded) const
+{
+  auto itype = itoken->getIType();
+
+  uint num_children = itoken->getNumChildren();
+
+  if      (itype == CExprITokenType::CONDITIONAL_EXPRESSION && num_children == 5) {
+    findExpressionUses(itoken->getChild(0), keys, calculated, loaded);
+
+    auto numCalculated = calculated.size();
+
+    findExpressionUses(itoken->getChild(2), keys, calculated, loaded);
+
+    calculated.resize(numCalculated);
+
+    findExpressionUses(itoken->getChild(4), keys, calculated, loaded);
+
+    calculated.resize(numCalculated);
+
+    return;
+  }
+  else if ((itype == CExprITokenType::LOGICAL_OR_EXPRESSION ||
+            itype == CExprITokenType::LOGICAL_AND_EXPRESSION) && num_children == 3) {
+    findExpressionUses(itoken->getChild(0), keys, calculated, loaded);
+
+    auto numCalculated = calculated.size();
+
+    findExpressionUses(itoken->getChild(2), keys, calculated, loaded);
+
+    calculated.resize(numCalculated);
+
+    return;
+  }
+
+  auto p = keys.find(itoken.get());
+
+  if (p != keys.end()) {
+    if (std::find(calculated.begin(), calculated.end(), (*p).second) != calculated.end()) {
+      loaded.insert((*p).second);
+      return;
+    }
+  }
+
+  for (uint i = 0; i < num_children; ++i)
+    findExpressionUses(itoken->getChild(i), keys, calculated, loaded);
+
+  if (p != keys.end())
+    calculated.push_back((*p).second);
+}
+
+// get structural key of expression and add keys of candidate subexpressions.
+// Returns true if value is not constant
+bool
+CExprCompileImpl::
+expressionKey(CExprITokenPtr itoken, ExpressionKeys &keys, KeyCounts &counts,
+              std::string &key, bool &pure) const
+{
+  auto itype = itoken->getIType();
+
+  if (itype == CExprITokenType::TOKEN_TYPE) {
+    std::ostringstream ostr;
+
+    // full precision so different literals have different keys
+    ostr << std::setprecision(17) << int(itoken->getType()) << ":";
+
+    if (itoken->getType() == CExprTokenType::STRING) {
+      const auto &str = itoken->getString();
+
+      ostr << str.size() << ":" << str;
+    }
+    else
+      itoken->base()->print(ostr);
+
+    key = ostr.str();
+
+    if (itoken->getType() == CExprTokenType::OPERATOR) {
+      auto op = itoken->getOperator();
+
+      if (op == CExprOpType::INCREMENT || op == CExprOpType::DECREMENT)
+        pure = false;
+    }
+
+    if (itoken->getType() != CExprTokenType::IDENTIFIER)
+      return false;
+
+    CExprVariablePtr variable;
+
+    return ! isConstantVariable(itoken->getIdentifier(), variable);
+  }
+
+  uint num_children = itoken->getNumChildren();
+
+  // single child and bracketed expression have same value as child
+  if (num_children == 1)
+    return expressionKey(itoken->getChild(0), keys, counts, key, pure);
+
+  if (num_children == 3 && itype == CExprITokenType::PRIMARY_EXPRESSION)
+    return expressionKey(itoken->getChild(1), keys, counts, key, pure);
+
+  if (itype == CExprITokenType::ASSIGNMENT_EXPRESSION)
+    pure = false;
+
+  bool isCall = (itype == CExprITokenType::POSTFIX_EXPRESSION &&
+                 itoken->getChild(1)->getOperator() == CExprOpType::OPEN_RBRACKET);
+
+  if (isCall) {
+    CExprFunctionMgr::Functions functions;
+
+    expr_->getFunctions(itoken->getChild(0)->getIdentifier(), functions);
+
+    for (const auto &function : functions) {
+      if (function && ! function->isPure())
+        pure = false;
+    }
+  }
+
+  bool variable = isCall;
+
+  key = "(";
+
+  for (uint i = 0; i < num_children; ++i) {
+    std::string key1;
+
+    if (expressionKey(itoken->getChild(i), keys, counts, key1, pure))
+      variable = true;
+
+    if (i > 0) key += " ";
+
+    key += key1;
+  }
+
+  key += ")";
+
+  bool candidate = false;
+
+  switch (itype) {
+    case CExprITokenType::INCLUSIVE_OR_EXPRESSION:
+    case CExprITokenType::EXCLUSIVE_OR_EXPRESSION:
+    case CExprITokenType::AND_EXPRESSION:
+    case CExprITokenType::EQUALITY_EXPRESSION:
+    case CExprITokenType::RELATIONAL_EXPRESSION:
+    case CExprITokenType::SHIFT_EXPRESSION:
+    case CExprITokenType::ADDITIVE_EXPRESSION:
+    case CExprITokenType::MULTIPLICATIVE_EXPRESSION:
+    case CExprITokenType::POWER_EXPRESSION:
+    case CExprITokenType::UNARY_EXPRESSION:
+      candidate = true;
+      break;
+    case CExprITokenType::POSTFIX_EXPRESSION:
+      candidate = isCall;
+      break;
+    default:
+      break;
+  }
+
+  if (candidate && variable) {
+    keys[itoken.get()] = key;
+
+    ++counts[key];
+  }
+
+  return variable;
+}
+
+// push value of common subexpression if already calculated
+bool
+CExprCompileImpl::
+loadCommonExpression(CExprITokenPtr itoken)
+{
+  if (commonKeys_.empty())
+    return false;
+
+  auto p = commonKeys_.find(itoken.get());
+
+  if (p == commonKeys_.end())
+    return false;
+
+  for (const auto &temp : temps_) {
+    if (temp.key == (*p).second) {
+      stackInstruction(CExprInstruction(CExprOpCode::LOAD_TEMP, CExprOpType::UNKNOWN, temp.ind));
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// save calculated value of common subexpression for later uses
+void
+CExprCompileImpl::
+storeCommonExpression(CExprITokenPtr itoken)
+{
+  if (commonKeys_.empty() || errorData_.isError())
+    return;
+
+  auto p = commonKeys_.find(itoken.get());
+
+  if (p == commonKeys_.end())
+    return;
+
+  Temp temp;
+
+  temp.key = (*p).second;
+  temp.ind = program_.addTemp();
+
+  stackInstruction(CExprInstruction(CExprOpCode::STORE_TEMP, CExprOpType::UNKNOWN, temp.ind));
+
+  temps_.push_back(temp);
+}
+
+// Infer value types on operand stack and replace numeric operators with typed
+// operators where operand types are known. Types of variables are taken from
+// their current values and typed operators check their operand types at run
+// time, so the inferred types only need to be likely and not exact.
+void
+CExprCompileImpl::
+inferTypes()
+{
+  uint numInstructions = program_.numInstructions();
+
+  // types on stack at jump targets (all jumps are forward)
+  std::vector<bool>       isTarget   (numInstructions + 1, false);
+  std::vector<ValueTypes> targetTypes(numInstructions + 1);
+
+  ValueTypes types;
+  bool       reachable = true;
+
+  ValueTypes tempTypes(program_.numTemps(), CExprValueType::NONE);
+
+  for (uint pc = 0; pc < numInstructions; ++pc) {
+    if (isTarget[pc]) {
+      if (reachable)
+        mergeTypes(types, targetTypes[pc]);
+      else
+        types = targetTypes[pc];
+
+      reachable = true;
+    }
+
+    if (! reachable)
+      continue;
+
+    const auto &instruction = program_.instruction(pc);
+
+    uint depth = uint(types.size());
+
+    auto type1 = (depth > 1 ? types[depth - 2] : CExprValueType::NONE);
+    auto type2 = (depth > 0 ? types[depth - 1] : CExprValueType::NONE);
+
+    switch (instruction.code) {
+      case CExprOpCode::PUSH_VALUE:
+        types.push_back(program_.value(instruction.arg1)->getType());
+        break;
+      case CExprOpCode::LOAD_VAR: {
+        auto variable = expr_->getVariable(program_.identifier(instruction.arg1));
+
+        auto value = (variable ? variable->getValue() : CExprValuePtr());
+
+        types.push_back(value ? value->getType() : CExprValueType::NONE);
+
+        break;
+      }
+      case CExprOpCode::UNARY_OP:
+      case CExprOpCode::LOGICAL_UNARY_OP:
+      case CExprOpCode::BITWISE_UNARY_OP: {
+        types.back() = resultType(instruction.code, instruction.op, type2, type2);
+
+        auto code = typedOpCode(instruction.code, instruction.op, type2, type2);
+
+        if (code != CExprOpCode::NOP)
+          program_.setOpCode(pc, code);
+
+        break;
+      }
+      case CExprOpCode::BINARY_OP:
+      case CExprOpCode::LOGICAL_BINARY_OP:
+      case CExprOpCode::BITWISE_BINARY_OP: {
+        types.pop_back();
+
+        types.back() = resultType(instruction.code, instruction.op, type1, type2);
+
+        auto code = typedOpCode(instruction.code, instruction.op, type1, type2);
+
+        if (code != CExprOpCode::NOP)
+          program_.setOpCode(pc, code);
+
+        break;
+      }
+      case CExprOpCode::POWER_INT:
+        if (type2 != CExprValueType::INTEGER && type2 != CExprValueType::REAL)
+          types.back() = CExprValueType::NONE;
+        break;
+      case CExprOpCode::STORE_TEMP:
+        tempTypes[instruction.arg1] = type2;
+        break;
+      case CExprOpCode::LOAD_TEMP:
+        types.push_back(tempTypes[instruction.arg1]);
+        break;
+      case CExprOpCode::CALL: {
+        types.resize(depth - instruction.arg2);
+
+        types.push_back(program_.function(instruction.arg1)->resultType());
+
+        break;
+      }
+      case CExprOpCode::JUMP:
+      case CExprOpCode::JUMP_IF_FALSE:
+      case CExprOpCode::JUMP_IF_TRUE: {
+        if (instruction.code != CExprOpCode::JUMP)
+          types.pop_back();
+
+        uint target = instruction.arg1;
+
+        if (isTarget[target])
+          mergeTypes(targetTypes[target], types);
+        else
+          targetTypes[target] = types;
+
+        isTarget[target] = true;
+
+        if (instruction.code == CExprOpCode::JUMP)
+          reachable = false;
+
+        break;
+      }
+      default: {
+        // other instructions keep type of stored value or push unknown type
+        int effect = CExprProgram::stackEffect(instruction);
+
+        if      (effect > 0)
+          types.push_back(CExprValueType::NONE);
+        else if (effect < 0)
+          types.resize(depth + effect);
+
+        break;
+      }
+    }
+  }
+}
+
+// types of values which can be from different paths (NONE if they differ)
+void
+CExprCompileImpl::
+mergeTypes(ValueTypes &types, const ValueTypes &types1)
+{
+  types.resize(std::min(types.size(), types1.size()));
+
+  for (uint i = 0; i < types.size(); ++i) {
+    if (types[i] != types1[i])
+      types[i] = CExprValueType::NONE;
+  }
+}
+
+// generic opcode for typed operator opcode
+CExprOpCode
+CExprCompileImpl::
+untypedOpCode(CExprOpCode code)
+{
+  switch (code) {
+    case CExprOpCode::UNARY_OP_I:
+    case CExprOpCode::UNARY_OP_R:
+      return CExprOpCode::UNARY_OP;
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      return CExprOpCode::BINARY_OP;
+    default:
+      return code;
+  }
+}
+
+// typed opcode for operator with operand types (NOP if none)
+CExprOpCode
+CExprCompileImpl::
+typedOpCode(CExprOpCode code, CExprOpType op, CExprValueType type1, CExprValueType type2)
+{
+  bool isInteger1 = (type1 == CExprValueType::INTEGER);
+  bool isInteger2 = (type2 == CExprValueType::INTEGER);
+  bool isReal1    = (type1 == CExprValueType::REAL);
+  bool isReal2    = (type2 == CExprValueType::REAL);
+
+  if (code == CExprOpCode::UNARY_OP) {
+    if (resultType(code, op, type2, type2) == CExprValueType::NONE)
+      return CExprOpCode::NOP;
+
+    if (isInteger2) return CExprOpCode::UNARY_OP_I;
+    if (isReal2   ) return CExprOpCode::UNARY_OP_R;
+
+    return CExprOpCode::NOP;
+  }
+
+  if (code != CExprOpCode::BINARY_OP)
+    return CExprOpCode::NOP;
+
+  // integer divide by zero is real
+  if (op == CExprOpType::DIVIDE && isInteger1 && isInteger2)
+    return CExprOpCode::NOP;
+
+  switch (op) {
+    case CExprOpType::DIVIDE:
+    case CExprOpType::TIMES:
+    case CExprOpType::PLUS:
+    case CExprOpType::MINUS:
+    case CExprOpType::LESS:
+    case CExprOpType::LESS_EQUAL:
+    case CExprOpType::GREATER:
+    case CExprOpType::GREATER_EQUAL:
+    case CExprOpType::EQUAL:
+    case CExprOpType::NOT_EQUAL:
+      break;
+    default:
+      return CExprOpCode::NOP;
+  }
+
+  if      (isInteger1 && isInteger2) return CExprOpCode::BINARY_OP_II;
+  else if (isReal1    && isReal2   ) return CExprOpCode::BINARY_OP_RR;
+  else if (isInteger1 && isReal2   ) return CExprOpCode::BINARY_OP_IR;
+  else if (isReal1    && isInteger2) return CExprOpCode::BINARY_OP_RI;
+
+  return CExprOpCode::NOP;
+}
+
+// type of operator result for operand types (NONE if not known)
+CExprValueType
+CExprCompileImpl::
+resultType(CExprOpCode code, CExprOpType op, CExprValueType type1, CExprValueType type2)
+{
+  switch (code) {
+    case CExprOpCode::LOGICAL_UNARY_OP:
+    case CExprOpCode::LOGICAL_BINARY_OP:
+      return CExprValueType::BOOLEAN;
+    case CExprOpCode::BITWISE_UNARY_OP:
+    case CExprOpCode::BITWISE_BINARY_OP:
+      return CExprValueType::INTEGER;
+    case CExprOpCode::UNARY_OP:
+      if (op == CExprOpType::UNARY_PLUS || op == CExprOpType::UNARY_MINUS)
+        return type2;
+
+      // increment/decrement is only defined for numeric values
+      if (op == CExprOpType::INCREMENT || op == CExprOpType::DECREMENT) {
+        if (type2 == CExprValueType::INTEGER || type2 == CExprValueType::REAL)
+          return type2;
+      }
+
+      return CExprValueType::NONE;
+    case CExprOpCode::BINARY_OP:
+      break;
+    default:
+      return CExprValueType::NONE;
+  }
+
+  bool isInteger1 = (type1 == CExprValueType::INTEGER);
+  bool isInteger2 = (type2 == CExprValueType::INTEGER);
+  bool isReal1    = (type1 == CExprValueType::REAL);
+  bool isReal2    = (type2 == CExprValueType::REAL);
+
+  // integer divide by zero is real
+  if (op == CExprOpType::DIVIDE && isInteger1 && isInteger2)
+    return CExprValueType::NONE;
+
+  switch (op) {
+    case CExprOpType::LESS:
+    case CExprOpType::LESS_EQUAL:
+    case CExprOpType::GREATER:
+    case CExprOpType::GREATER_EQUAL:
+    case CExprOpType::EQUAL:
+    case CExprOpType::NOT_EQUAL:
+      return CExprValueType::BOOLEAN;
+    case CExprOpType::DIVIDE:
+    case CExprOpType::POWER:
+    case CExprOpType::TIMES:
+    case CExprOpType::MODULUS:
+    case CExprOpType::PLUS:
+    case CExprOpType::MINUS:
+      if (! (isInteger1 || isReal1) || ! (isInteger2 || isReal2))
+        return CExprValueType::NONE;
+
+      if (isReal1 || isReal2)
+        return CExprValueType::REAL;
+
+      return CExprValueType::INTEGER;
+    default:
+      return CExprValueType::NONE;
+  }
+}
+
+// add jump instruction (target set when known)
+uint
+CExprCompileImpl::
+stackJump(CExprOpCode code, CExprOpType op)
+{
+  return program_.addInstruction(CExprInstruction(code, op));
+}
+
+// result of short circuit && or || : jumps taken give 'value', fall through gives '!value'
+void
+CExprCompileImpl::
+stackShortCircuitResult(uint lhsJump, uint rhsJump, bool value)
+{
+  int depth = program_.depth();
+
+  stackValue(expr_->createBooleanValue(! value));
+
+  uint endJump = stackJump(CExprOpCode::JUMP);
+
+  program_.setDepth(depth);
+
+  program_.setJumpTarget(lhsJump, program_.numInstructions());
+  program_.setJumpTarget(rhsJump, program_.numInstructions());
+
+  stackValue(expr_->createBooleanValue(value));
 
-  stackCToken(base);
+  program_.setJumpTarget(endJump, program_.numInstructions());
 }
 
 void
 CExprCompileImpl::
-stackCToken(const CExprTokenBaseP &base)
+stackInstruction(const CExprInstruction &instruction)
 {
-  tokenStack_.addToken(base);
+  program_.addInstruction(instruction);
 }
 
 bool
 CExprCompileImpl::
 hasFunction(const std::string &name) const
 {
-  return tokenStack_.hasFunction(name);
+  return program_.hasFunction(name);
 }
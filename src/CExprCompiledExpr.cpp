@@ -0,0 +1,89 @@
+#include <CExprI.h>
+
+CExprCompiledExpr::
+CExprCompiledExpr(CExpr *expr, const std::string &str) :
+ expr_(expr), str_(str)
+{
+  pstack_ = expr_->parseLine(str_);
+  itoken_ = expr_->interpPTokenStack(pstack_);
+
+  (void) compile();
+}
+
+// compile already parsed expression
+CExprCompiledExpr::
+CExprCompiledExpr(CExpr *expr, const std::string &str, const CExprTokenStack &pstack) :
+ expr_(expr), str_(str), pstack_(pstack)
+{
+  itoken_ = expr_->interpPTokenStack(pstack_);
+
+  (void) compile();
+}
+
+bool
+CExprCompiledExpr::
+compile()
+{
+  generation_ = expr_->functionGeneration();
+
+  program_ = expr_->compileIToken(itoken_);
+
+  valid_ = ! program_.empty();
+
+  return valid_;
+}
+
+// recompile if functions changed since compiled
+bool
+CExprCompiledExpr::
+update()
+{
+  if (generation_ != expr_->functionGeneration())
+    return compile();
+
+  return valid_;
+}
+
+bool
+CExprCompiledExpr::
+evaluate(CExprValueArray &values)
+{
+  if (! update())
+    return false;
+
+  return expr_->executeProgram(program_, values);
+}
+
+bool
+CExprCompiledExpr::
+evaluate(CExprValuePtr &value)
+{
+  if (! update())
+    return false;
+
+  return expr_->executeProgram(program_, value);
+}
+
+bool
+CExprCompiledExpr::
+evaluate(double &r)
+{
+  CExprValuePtr value;
+
+  if (! evaluate(value) || ! value)
+    return false;
+
+  return value->getRealValue(r);
+}
+
+bool
+CExprCompiledExpr::
+evaluate(long &l)
+{
+  CExprValuePtr value;
+
+  if (! evaluate(value) || ! value)
+    return false;
+
+  return value->getIntegerValue(l);
+}
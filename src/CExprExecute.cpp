@@ -1,5 +1,11 @@
 #include <CExprI.h>
 #include <sstream>
+#include <algorithm>
+
+// use GCC labels-as-values for direct threaded dispatch of instructions
+#if defined(__GNUC__) && ! defined(CEXPR_NO_THREADED_DISPATCH)
+#define CEXPR_THREADED_DISPATCH 1
+#endif
 
 class CExprExecuteImpl {
  public:
@@ -7,43 +13,79 @@ class CExprExecuteImpl {
 
  ~CExprExecuteImpl() { }
 
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values);
-  bool executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value);
+  bool executeProgram(const CExprProgram &program, CExprValueArray &values);
+  bool executeProgram(const CExprProgram &program, CExprValuePtr &value);
 
  private:
-  bool executeToken                (const CExprTokenBaseP &ctoken);
-  bool executeOperator             (const CExprTokenBaseP &ctoken);
-  void executeQuestionOperator     ();
-  void executeUnaryOperator        (CExprOpType type);
-  void executeLogicalUnaryOperator (CExprOpType type);
-  void executeBitwiseUnaryOperator (CExprOpType type);
-  bool executeBinaryOperator       (CExprOpType type);
-  void executeLogicalBinaryOperator(CExprOpType type);
-  void executeBitwiseBinaryOperator(CExprOpType type);
-  void executeColonOperator        ();
-  void executeCommaOperator        ();
-  void executeEqualsOperator       ();
-  bool executeFunction             (const CExprFunctionPtr &function, CExprValuePtr &value);
-  bool executeBlock                (const CExprTokenStack &stack, CExprValuePtr &value);
-
-  CExprValuePtr  etokenToValue(const CExprTokenBaseP &etoken);
-#if 0
-  CExprValueType etokenToValueType(const CExprTokenBaseP &etoken);
-#endif
+  bool runProgram(const CExprProgram &program);
 
-  void stackValue (const CExprValuePtr &value);
-  void stackBlock ();
-  void stackEToken(const CExprTokenBaseP &etoken);
+  bool executeInstructions();
+#ifdef CEXPR_THREADED_DISPATCH
+  bool executeThreaded();
+#endif
 
-  CExprValuePtr   unstackValue ();
-  CExprTokenBaseP unstackEToken();
+  bool executeInstruction          (const CExprInstruction &instruction);
+  bool executeCondition            (CExprOpType type, bool &flag);
+  bool executeUnaryOperator        (CExprOpType type);
+  bool executeLogicalUnaryOperator (CExprOpType type);
+  bool executeBitwiseUnaryOperator (CExprOpType type);
+  bool executeBinaryOperator       (CExprOpType type);
+  bool executeLogicalBinaryOperator(CExprOpType type);
+  bool executeBitwiseBinaryOperator(CExprOpType type);
+  bool executeBinaryVariable       (const CExprInstruction &instruction);
+  bool executeBinaryCondition      (const CExprInstruction &instruction, bool &flag);
+  bool executePowerInteger         (uint exponent);
+  bool executeTypedUnaryOperator   (CExprOpCode code, CExprOpType type);
+  bool executeTypedBinaryOperator  (CExprOpCode code, CExprOpType type);
+  bool executeLoadVariable         (uint ind);
+  bool executeStoreVariable        (uint ind);
+  bool executeFunction             (const CExprFunctionPtr &function, uint numArgs);
+
+  bool executeRegisterCode          (const CExprRegisterCode &code);
+  bool executeRegisterInstruction   (const CExprRegInstruction &instruction);
+  CExprValuePtr registerOperandValue(const CExprRegOperand &operand) const;
+
+  bool unaryOperator        (CExprOpType type, CExprValuePtr value, CExprValuePtr &result);
+  bool logicalUnaryOperator (CExprOpType type, CExprValuePtr value, CExprValuePtr &result);
+  bool bitwiseUnaryOperator (CExprOpType type, CExprValuePtr value, CExprValuePtr &result);
+  bool binaryOperator       (CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+                             CExprValuePtr &result);
+  bool logicalBinaryOperator(CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+                             CExprValuePtr &result);
+  bool bitwiseBinaryOperator(CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+                             CExprValuePtr &result);
+  bool typedUnaryOperator   (CExprOpCode code, CExprOpType type, const CExprValuePtr &value,
+                             CExprValuePtr &result);
+  bool typedBinaryOperator  (CExprOpCode code, CExprOpType type, const CExprValuePtr &value1,
+                             const CExprValuePtr &value2, CExprValuePtr &result);
+  bool powerIntegerOperator (const CExprValuePtr &value, uint exponent, CExprValuePtr &result);
+  bool binaryCodeOperator   (CExprOpCode code, CExprOpType type, const CExprValuePtr &value1,
+                             const CExprValuePtr &value2, CExprValuePtr &result);
+  bool conditionValue       (CExprOpType type, const CExprValuePtr &value, bool &flag);
+  bool storeVariable        (uint ind, const CExprValuePtr &value, CExprValuePtr &result);
+  bool callFunction         (const CExprFunctionPtr &function, CExprValuePtr *args,
+                             uint numArgs, CExprValuePtr &result);
+  bool callFunction         (const CExprFunctionPtr &function, CExprValueArray &values,
+                             CExprValuePtr &result);
+
+  void          stackValue  (const CExprValuePtr &value);
+  CExprValuePtr unstackValue();
+  void          clearStack  ();
+
+  void printStack(std::ostream &os) const;
+  void printRegisters(std::ostream &os) const;
 
  private:
-  CExpr*          expr_       { nullptr };
-  CExprTokenStack ctokenStack_;
-  uint            ctokenPos_  { 0 };
-  uint            numCTokens_ { 0 };
-  CExprTokenStack etokenStack_;
+  using Values = std::vector<CExprValuePtr>;
+
+  CExpr*              expr_    { nullptr };
+  const CExprProgram* program_ { nullptr };
+  uint                pc_      { 0 };
+  Values              stack_;
+  uint                sp_      { 0 };
+  Values              registers_;
+  Values              temps_;
+  CExprValueArray     args_;
 };
 
 //------------
@@ -62,298 +104,458 @@ CExprExecute::
 
 bool
 CExprExecute::
-executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values)
+executeProgram(const CExprProgram &program, CExprValueArray &values)
 {
-  return impl_->executeCTokenStack(stack, values);
+  return impl_->executeProgram(program, values);
 }
 
 bool
 CExprExecute::
-executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value)
+executeProgram(const CExprProgram &program, CExprValuePtr &value)
 {
-  return impl_->executeCTokenStack(stack, value);
+  return impl_->executeProgram(program, value);
 }
 
 //------------
 
 bool
 CExprExecuteImpl::
-executeCTokenStack(const CExprTokenStack &stack, CExprValueArray &values)
+executeProgram(const CExprProgram &program, CExprValueArray &values)
 {
-  ctokenStack_ = stack;
-
-  etokenStack_.clear();
-
-  numCTokens_ = ctokenStack_.getNumTokens();
-  ctokenPos_  = 0;
-
-  while (ctokenPos_ < numCTokens_) {
-    auto ctoken = ctokenStack_.getToken(ctokenPos_++);
+  if (! runProgram(program))
+    return false;
 
-    if (! executeToken(ctoken))
-      return false;
+  values.reserve(values.size() + sp_);
 
-    if (expr_->getDebug())
-      std::cerr << "EToken Stack:" << etokenStack_ << "\n";
+  // operator without a result value (invalid operand types) gives no value
+  for (uint i = 0; i < sp_; ++i) {
+    if (stack_[i])
+      values.push_back(stack_[i]);
   }
 
-  std::deque<CExprValuePtr> values1;
+  clearStack();
 
-  bool rc = true;
+  return true;
+}
+
+bool
+CExprExecuteImpl::
+executeProgram(const CExprProgram &program, CExprValuePtr &value)
+{
+  if (! runProgram(program))
+    return false;
 
-  while (! etokenStack_.empty()) {
-    auto value = unstackValue();
+  // last result value (null if none)
+  value = CExprValuePtr();
 
-    if (value)
-      values1.push_front(value);
-    else
-      rc = false;
+  for (uint i = sp_; i > 0; --i) {
+    if (stack_[i - 1]) {
+      value = stack_[i - 1];
+      break;
+    }
   }
 
-  std::copy(values1.begin(), values1.end(), std::back_inserter(values));
+  clearStack();
 
-  return rc;
+  return true;
 }
 
+// run program in place leaving result values on stack
 bool
 CExprExecuteImpl::
-executeCTokenStack(const CExprTokenStack &stack, CExprValuePtr &value)
+runProgram(const CExprProgram &program)
 {
-  CExprValueArray values;
+  program_ = &program;
 
-  if (! executeCTokenStack(stack, values))
-    return false;
+  // stack allocated once for max depth of programs run by this executor
+  clearStack();
 
-  if (values.empty())
-    value = CExprValuePtr();
+  uint depth = program.maxDepth();
+
+  if (program.registerCode())
+    depth = std::max(depth, uint(program.registerCode()->results().size()));
+
+  if (stack_.size() < depth)
+    stack_.resize(depth);
+
+  if (temps_.size() < program.numTemps())
+    temps_.resize(program.numTemps());
+
+  bool rc;
+
+  if      (expr_->getRegisterVM() && program.registerCode())
+    rc = executeRegisterCode(*program.registerCode());
+#ifdef CEXPR_THREADED_DISPATCH
+  // debug uses switch loop to trace each instruction
+  else if (! expr_->getDebug())
+    rc = executeThreaded();
+#endif
   else
-    value = values.back();
+    rc = executeInstructions();
+
+  program_ = nullptr;
+
+  // release common subexpression values
+  for (uint i = 0; i < program.numTemps(); ++i)
+    temps_[i] = CExprValuePtr();
+
+  if (! rc) {
+    clearStack();
+    return false;
+  }
 
   return true;
 }
 
 bool
 CExprExecuteImpl::
-executeToken(const CExprTokenBaseP &ctoken)
+executeInstructions()
 {
-  switch (ctoken->type()) {
-    case CExprTokenType::IDENTIFIER:
-      stackEToken(ctoken);
+  uint numInstructions = program_->numInstructions();
 
-      break;
-    case CExprTokenType::OPERATOR:
-      if (! executeOperator(ctoken))
-        return false;
+  pc_ = 0;
 
-      break;
-    case CExprTokenType::INTEGER: {
-      auto value = expr_->createIntegerValue(ctoken->getInteger());
+  while (pc_ < numInstructions) {
+    const auto &instruction = program_->instruction(pc_++);
 
-      stackValue(value);
+    if (! executeInstruction(instruction))
+      return false;
 
-      break;
+    if (expr_->getDebug()) {
+      std::cerr << "Value Stack:";
+      printStack(std::cerr);
+      std::cerr << "\n";
     }
-    case CExprTokenType::REAL: {
-      auto value = expr_->createRealValue(ctoken->getReal());
+  }
 
-      stackValue(value);
+  return true;
+}
 
-      break;
-    }
-    case CExprTokenType::STRING: {
-      auto value = expr_->createStringValue(ctoken->getString());
+#ifdef CEXPR_THREADED_DISPATCH
+// execute instructions by jumping directly from handler to handler.
+// Handler addresses are stored in the instructions on first execution.
+bool
+CExprExecuteImpl::
+executeThreaded()
+{
+  // indexed by CExprOpCode
+  static void *handlers[] = {
+    &&op_nop,
+    &&op_push_value,
+    &&op_push_null,
+    &&op_load_var,
+    &&op_store_var,
+    &&op_pop,
+    &&op_unary,
+    &&op_logical_unary,
+    &&op_bitwise_unary,
+    &&op_binary,
+    &&op_logical_binary,
+    &&op_bitwise_binary,
+    &&op_call,
+    &&op_jump,
+    &&op_jump_if_false,
+    &&op_jump_if_true,
+    &&op_unary_typed,  // UNARY_OP_I
+    &&op_unary_typed,  // UNARY_OP_R
+    &&op_binary_typed, // BINARY_OP_II
+    &&op_binary_typed, // BINARY_OP_RR
+    &&op_binary_typed, // BINARY_OP_IR
+    &&op_binary_typed, // BINARY_OP_RI
+    &&op_store_temp,
+    &&op_load_temp,
+    &&op_binary_var,  // BINARY_VAR_CONST
+    &&op_binary_var,  // BINARY_VAR_VAR
+    &&op_binary_jump_if_false,
+    &&op_binary_jump_if_true,
+    &&op_power_int,
+    &&op_invalid, // MOVE
+  };
+
+  static_assert(sizeof(handlers)/sizeof(handlers[0]) == uint(CExprOpCode::MOVE) + 1,
+                "handler table does not match CExprOpCode");
+
+  const auto &instructions = program_->instructions();
+
+  if (instructions.empty())
+    return true;
+
+  if (! program_->isHandlersResolved()) {
+    for (const auto &instruction : instructions)
+      instruction.handler = handlers[uint(instruction.code)];
+
+    program_->setHandlersResolved();
+  }
 
-      stackValue(value);
+  const CExprInstruction *begin = &instructions[0];
+  const CExprInstruction *end   = begin + instructions.size();
+  const CExprInstruction *ip    = begin;
+  const CExprInstruction *instruction;
 
-      break;
-    }
-    case CExprTokenType::FUNCTION: {
-      stackEToken(ctoken);
+  bool flag;
 
-      break;
-    }
-    case CExprTokenType::VALUE:
-      stackEToken(ctoken);
+#define CEXPR_DISPATCH() \
+  if (ip == end) return true; \
+  instruction = ip++; \
+  goto *instruction->handler
 
-      break;
-    default:
-      assert(false);
-      break;
-  }
+  CEXPR_DISPATCH();
 
-  return true;
+ op_nop:
+  CEXPR_DISPATCH();
+
+ op_push_value:
+  stackValue(program_->value(instruction->arg1));
+  CEXPR_DISPATCH();
+
+ op_push_null:
+  stackValue(CExprValuePtr());
+  CEXPR_DISPATCH();
+
+ op_load_var:
+  if (! executeLoadVariable(instruction->arg1)) return false;
+  CEXPR_DISPATCH();
+
+ op_store_var:
+  if (! executeStoreVariable(instruction->arg1)) return false;
+  CEXPR_DISPATCH();
+
+ op_pop:
+  unstackValue();
+  CEXPR_DISPATCH();
+
+ op_unary:
+  if (! executeUnaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_logical_unary:
+  if (! executeLogicalUnaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_bitwise_unary:
+  if (! executeBitwiseUnaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_binary:
+  if (! executeBinaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_logical_binary:
+  if (! executeLogicalBinaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_bitwise_binary:
+  if (! executeBitwiseBinaryOperator(instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_call:
+  if (! executeFunction(program_->function(instruction->arg1), instruction->arg2)) return false;
+  CEXPR_DISPATCH();
+
+ op_jump:
+  ip = begin + instruction->arg1;
+  CEXPR_DISPATCH();
+
+ op_jump_if_false:
+  if (! executeCondition(instruction->op, flag)) return false;
+  if (! flag) ip = begin + instruction->arg1;
+  CEXPR_DISPATCH();
+
+ op_jump_if_true:
+  if (! executeCondition(instruction->op, flag)) return false;
+  if (flag) ip = begin + instruction->arg1;
+  CEXPR_DISPATCH();
+
+ op_store_temp:
+  temps_[instruction->arg1] = stack_[sp_ - 1];
+  CEXPR_DISPATCH();
+
+ op_load_temp:
+  stackValue(temps_[instruction->arg1]);
+  CEXPR_DISPATCH();
+
+ op_binary_var:
+  if (! executeBinaryVariable(*instruction)) return false;
+  CEXPR_DISPATCH();
+
+ op_binary_jump_if_false:
+  if (! executeBinaryCondition(*instruction, flag)) return false;
+  if (! flag) ip = begin + instruction->arg1;
+  CEXPR_DISPATCH();
+
+ op_binary_jump_if_true:
+  if (! executeBinaryCondition(*instruction, flag)) return false;
+  if (flag) ip = begin + instruction->arg1;
+  CEXPR_DISPATCH();
+
+ op_power_int:
+  if (! executePowerInteger(instruction->arg1)) return false;
+  CEXPR_DISPATCH();
+
+ op_unary_typed:
+  if (! executeTypedUnaryOperator(instruction->code, instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_binary_typed:
+  if (! executeTypedBinaryOperator(instruction->code, instruction->op)) return false;
+  CEXPR_DISPATCH();
+
+ op_invalid:
+  expr_->errorMsg("Invalid instruction for 'executeThreaded'");
+  return false;
+
+#undef CEXPR_DISPATCH
 }
+#endif
 
 bool
 CExprExecuteImpl::
-executeOperator(const CExprTokenBaseP &ctoken)
+executeInstruction(const CExprInstruction &instruction)
 {
-  auto type = ctoken->getOperator();
-
-  switch (type) {
-    case CExprOpType::LOGICAL_NOT:
-      executeLogicalUnaryOperator(type);
-      break;
-    case CExprOpType::BIT_NOT:
-      executeBitwiseUnaryOperator(type);
+  switch (instruction.code) {
+    case CExprOpCode::NOP:
       break;
-    case CExprOpType::UNARY_PLUS:
-    case CExprOpType::UNARY_MINUS:
-      executeUnaryOperator(type);
+    case CExprOpCode::PUSH_VALUE:
+      stackValue(program_->value(instruction.arg1));
       break;
-    case CExprOpType::POWER:
-    case CExprOpType::TIMES:
-    case CExprOpType::DIVIDE:
-    case CExprOpType::MODULUS:
-    case CExprOpType::PLUS:
-    case CExprOpType::MINUS:
-    case CExprOpType::LESS:
-    case CExprOpType::LESS_EQUAL:
-    case CExprOpType::GREATER:
-    case CExprOpType::GREATER_EQUAL:
-    case CExprOpType::EQUAL:
-    case CExprOpType::NOT_EQUAL:
-      if (! executeBinaryOperator(type))
-        return false;
-
-      break;
-    case CExprOpType::LOGICAL_AND:
-    case CExprOpType::LOGICAL_OR:
-      executeLogicalBinaryOperator(type);
-      break;
-    case CExprOpType::BIT_LSHIFT:
-    case CExprOpType::BIT_RSHIFT:
-    case CExprOpType::BIT_AND:
-    case CExprOpType::BIT_XOR:
-    case CExprOpType::BIT_OR:
-      executeBitwiseBinaryOperator(type);
+    case CExprOpCode::PUSH_NULL:
+      stackValue(CExprValuePtr());
       break;
-    case CExprOpType::QUESTION:
-      executeQuestionOperator();
+    case CExprOpCode::LOAD_VAR:
+      return executeLoadVariable(instruction.arg1);
+    case CExprOpCode::STORE_VAR:
+      return executeStoreVariable(instruction.arg1);
+    case CExprOpCode::POP:
+      unstackValue();
       break;
-    case CExprOpType::COLON:
-      executeColonOperator();
+    case CExprOpCode::UNARY_OP:
+      return executeUnaryOperator(instruction.op);
+    case CExprOpCode::LOGICAL_UNARY_OP:
+      return executeLogicalUnaryOperator(instruction.op);
+    case CExprOpCode::BITWISE_UNARY_OP:
+      return executeBitwiseUnaryOperator(instruction.op);
+    case CExprOpCode::BINARY_OP:
+      return executeBinaryOperator(instruction.op);
+    case CExprOpCode::LOGICAL_BINARY_OP:
+      return executeLogicalBinaryOperator(instruction.op);
+    case CExprOpCode::BITWISE_BINARY_OP:
+      return executeBitwiseBinaryOperator(instruction.op);
+    case CExprOpCode::UNARY_OP_I:
+    case CExprOpCode::UNARY_OP_R:
+      return executeTypedUnaryOperator(instruction.code, instruction.op);
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      return executeTypedBinaryOperator(instruction.code, instruction.op);
+    case CExprOpCode::STORE_TEMP:
+      temps_[instruction.arg1] = stack_[sp_ - 1];
       break;
-    case CExprOpType::EQUALS:
-      executeEqualsOperator();
+    case CExprOpCode::LOAD_TEMP:
+      stackValue(temps_[instruction.arg1]);
       break;
-    case CExprOpType::COMMA:
-      executeCommaOperator();
-      break;
-    case CExprOpType::OPEN_RBRACKET:
-      stackEToken(ctoken);
+    case CExprOpCode::BINARY_VAR_CONST:
+    case CExprOpCode::BINARY_VAR_VAR:
+      return executeBinaryVariable(instruction);
+    case CExprOpCode::BINARY_JUMP_IF_FALSE:
+    case CExprOpCode::BINARY_JUMP_IF_TRUE: {
+      bool flag;
+
+      if (! executeBinaryCondition(instruction, flag))
+        return false;
+
+      if (flag == (instruction.code == CExprOpCode::BINARY_JUMP_IF_TRUE))
+        pc_ = instruction.arg1;
+
       break;
-    case CExprOpType::START_BLOCK:
-      stackBlock();
+    }
+    case CExprOpCode::POWER_INT:
+      return executePowerInteger(instruction.arg1);
+    case CExprOpCode::CALL:
+      return executeFunction(program_->function(instruction.arg1), instruction.arg2);
+    case CExprOpCode::JUMP:
+      pc_ = instruction.arg1;
       break;
-    case CExprOpType::UNKNOWN:
-      stackEToken(ctoken);
+    case CExprOpCode::JUMP_IF_FALSE:
+    case CExprOpCode::JUMP_IF_TRUE: {
+      bool flag;
+
+      if (! executeCondition(instruction.op, flag))
+        return false;
+
+      if (flag == (instruction.code == CExprOpCode::JUMP_IF_TRUE))
+        pc_ = instruction.arg1;
+
       break;
-    default: {
-      expr_->errorMsg("Invalid operator for 'executeOperator'");
-      return false;
     }
+    default:
+      expr_->errorMsg("Invalid instruction for 'executeInstruction'");
+      return false;
   }
 
   return true;
 }
 
-void
+/* <value> <jump> */
+bool
 CExprExecuteImpl::
-executeQuestionOperator()
+executeCondition(CExprOpType type, bool &flag)
 {
   // pop boolean
   auto value = unstackValue();
-  if (! value) return;
-
-  bool flag;
-
-  if (! value->getBooleanValue(flag))
-    flag = false;
-
-  //---
-
-  // pop second token (rhs=false)
-  auto etoken2 = unstackEToken();
-
-  //---
-
-  // pop first token (lhs=tue)
-  auto etoken1 = unstackEToken();
-
-  //---
-
-  CExprValuePtr value1;
-
-  if (flag) {
-    if (etoken1)
-      value1 = etokenToValue(etoken1);
-  }
-  else {
-    if (etoken2)
-      value1 = etokenToValue(etoken2);
-  }
 
-  if (! value1)
-    return;
-
-  stackValue(value1);
+  return conditionValue(type, value, flag);
 }
 
 /* <value> <unary_op> */
-void
+bool
 CExprExecuteImpl::
 executeUnaryOperator(CExprOpType type)
 {
   auto value = unstackValue();
-  if (! value) return;
 
-  auto value1 = value->execUnaryOp(expr_, type);
-  if (! value1) return;
+  CExprValuePtr result;
+
+  if (! unaryOperator(type, value, result))
+    return false;
+
+  stackValue(result);
 
-  stackValue(value1);
+  return true;
 }
 
 /* <value> <unary_op> */
-void
+bool
 CExprExecuteImpl::
 executeLogicalUnaryOperator(CExprOpType type)
 {
   auto value = unstackValue();
-  if (! value) return;
 
-  if (! value->isBooleanValue()) {
-    value = CExprValuePtr(value->dup());
+  CExprValuePtr result;
 
-    if (! value->convToBoolean())
-      return;
-  }
+  if (! logicalUnaryOperator(type, value, result))
+    return false;
 
-  auto value1 = value->execUnaryOp(expr_, type);
-  if (! value1) return;
+  stackValue(result);
 
-  stackValue(value1);
+  return true;
 }
 
 /* <value> <unary_op> */
-void
+bool
 CExprExecuteImpl::
 executeBitwiseUnaryOperator(CExprOpType type)
 {
   auto value = unstackValue();
-  if (! value) return;
 
-  if (! value->isIntegerValue()) {
-    value = CExprValuePtr(value->dup());
+  CExprValuePtr result;
 
-    if (! value->convToInteger())
-      return;
-  }
+  if (! bitwiseUnaryOperator(type, value, result))
+    return false;
 
-  auto value1 = value->execUnaryOp(expr_, type);
-  if (! value1) return;
+  stackValue(result);
 
-  stackValue(value1);
+  return true;
 }
 
 /* <value1> <value2> <binary_op> */
@@ -367,44 +569,41 @@ executeBinaryOperator(CExprOpType type)
   // pop lhs
   auto value1 = unstackValue();
 
-  //---
+  CExprValuePtr result;
 
-  if (! value1 || ! value2)
+  if (! binaryOperator(type, value1, value2, result))
     return false;
 
-  bool convReal = false;
-
-  if (value1->isRealValue() || value2->isRealValue())
-    convReal = true;
+  stackValue(result);
 
-  if (! convReal && type == CExprOpType::DIVIDE && value2->isIntegerValue()) {
-    long l = 0;
-
-    value2->getIntegerValue(l);
+  return true;
+}
 
-    if (l == 0)
-      convReal = true;
-  }
+/* <value1> <value2> <binary_op> */
+bool
+CExprExecuteImpl::
+executeLogicalBinaryOperator(CExprOpType type)
+{
+  // pop rhs
+  auto value2 = unstackValue();
 
-  if (convReal) {
-    if (! value1->isRealValue()) value1 = CExprValuePtr(value1->dup());
-    if (! value2->isRealValue()) value2 = CExprValuePtr(value2->dup());
+  // pop lhs
+  auto value1 = unstackValue();
 
-    if (! value1->convToReal()) return false;
-    if (! value2->convToReal()) return false;
-  }
+  CExprValuePtr result;
 
-  auto value = value1->execBinaryOp(expr_, value2, type);
+  if (! logicalBinaryOperator(type, value1, value2, result))
+    return false;
 
-  stackValue(value);
+  stackValue(result);
 
   return true;
 }
 
 /* <value1> <value2> <binary_op> */
-void
+bool
 CExprExecuteImpl::
-executeLogicalBinaryOperator(CExprOpType type)
+executeBitwiseBinaryOperator(CExprOpType type)
 {
   // pop rhs
   auto value2 = unstackValue();
@@ -412,34 +611,50 @@ executeLogicalBinaryOperator(CExprOpType type)
   // pop lhs
   auto value1 = unstackValue();
 
-  //---
+  CExprValuePtr result;
 
-  if (! value1 || ! value2)
-    return;
+  if (! bitwiseBinaryOperator(type, value1, value2, result))
+    return false;
 
-  if (! value1->isBooleanValue()) {
-    value1 = CExprValuePtr(value1->dup());
+  stackValue(result);
 
-    if (! value1->convToBoolean())
-      return;
-  }
+  return true;
+}
 
-  if (! value2->isBooleanValue()) {
-    value2 = CExprValuePtr(value2->dup());
+/* <binary_var_const> or <binary_var_var> */
+bool
+CExprExecuteImpl::
+executeBinaryVariable(const CExprInstruction &instruction)
+{
+  auto variable1 = program_->variable(expr_, instruction.arg1);
 
-    if (! value2->convToBoolean())
-      return;
+  auto value1 = (variable1 ? variable1->getValue() : CExprValuePtr());
+
+  CExprValuePtr value2;
+
+  if (instruction.code == CExprOpCode::BINARY_VAR_CONST)
+    value2 = program_->value(instruction.arg2);
+  else {
+    auto variable2 = program_->variable(expr_, instruction.arg2);
+
+    if (variable2)
+      value2 = variable2->getValue();
   }
 
-  auto value = value1->execBinaryOp(expr_, value2, type);
+  CExprValuePtr result;
+
+  if (! binaryCodeOperator(instruction.fused, instruction.op, value1, value2, result))
+    return false;
+
+  stackValue(result);
 
-  stackValue(value);
+  return true;
 }
 
-/* <value1> <value2> <binary_op> */
-void
+/* <value1> <value2> <binary_jump> */
+bool
 CExprExecuteImpl::
-executeBitwiseBinaryOperator(CExprOpType type)
+executeBinaryCondition(const CExprInstruction &instruction, bool &flag)
 {
   // pop rhs
   auto value2 = unstackValue();
@@ -447,250 +662,832 @@ executeBitwiseBinaryOperator(CExprOpType type)
   // pop lhs
   auto value1 = unstackValue();
 
-  //---
+  CExprValuePtr result;
 
-  if (! value1 || ! value2)
-    return;
+  if (! binaryCodeOperator(instruction.fused, instruction.op, value1, value2, result))
+    return false;
 
-  if (! value1->isIntegerValue()) {
-    value1 = CExprValuePtr(value1->dup());
+  // condition uses operator of fused jump
+  return conditionValue(CExprOpType(instruction.arg2), result, flag);
+}
 
-    if (! value1->convToInteger())
-      return;
-  }
+/* <value> <power_int> (value replaced in place) */
+bool
+CExprExecuteImpl::
+executePowerInteger(uint exponent)
+{
+  if (sp_ < 1)
+    return false;
 
-  if (! value2->isIntegerValue()) {
-    value2 = CExprValuePtr(value2->dup());
+  CExprValuePtr result;
 
-    if (! value2->convToInteger())
-      return;
-  }
+  if (! powerIntegerOperator(stack_[sp_ - 1], exponent, result))
+    return false;
 
-  auto value = value1->execBinaryOp(expr_, value2, type);
+  stack_[sp_ - 1] = std::move(result);
 
-  stackValue(value);
+  return true;
 }
 
-void
+/* <value> <typed_unary_op> (value replaced in place) */
+bool
 CExprExecuteImpl::
-executeColonOperator()
+executeTypedUnaryOperator(CExprOpCode code, CExprOpType type)
 {
-}
+  if (sp_ < 1)
+    return executeUnaryOperator(type);
 
-void
-CExprExecuteImpl::
-executeCommaOperator()
-{
+  CExprValuePtr result;
+
+  // generic operator if value not expected type
+  if (! typedUnaryOperator(code, type, stack_[sp_ - 1], result))
+    return executeUnaryOperator(type);
+
+  stack_[sp_ - 1] = std::move(result);
+
+  return true;
 }
 
-void
+/* <value1> <value2> <typed_binary_op> (values replaced in place) */
+bool
 CExprExecuteImpl::
-executeEqualsOperator()
+executeTypedBinaryOperator(CExprOpCode code, CExprOpType type)
 {
-  // rhs
-  auto value1 = unstackValue();
-  if (! value1) return;
+  if (sp_ < 2)
+    return executeBinaryOperator(type);
 
-  //---
+  CExprValuePtr result;
 
-  auto etoken2 = unstackEToken();
-  if (! etoken2) return;
+  // generic operator if values not expected types
+  if (! typedBinaryOperator(code, type, stack_[sp_ - 2], stack_[sp_ - 1], result))
+    return executeBinaryOperator(type);
 
-  //---
+  stack_[--sp_]   = CExprValuePtr();
+  stack_[sp_ - 1] = std::move(result);
 
-  CExprValuePtr value;
+  return true;
+}
 
-  if (etoken2->type() == CExprTokenType::IDENTIFIER) {
-    auto variable = expr_->createVariable(etoken2->getIdentifier(), value1);
+bool
+CExprExecuteImpl::
+executeLoadVariable(uint ind)
+{
+  const auto &variable = program_->variable(expr_, ind);
 
-    value = variable->getValue();
-  }
-  else {
-    expr_->errorMsg("Non lvalue for asssignment");
-    return;
-  }
+  // undefined variable has no value (fails evaluation)
+  if (! variable)
+    return false;
+
+  stackValue(variable->getValue());
 
-  stackValue(value);
+  return true;
 }
 
 bool
 CExprExecuteImpl::
-executeFunction(const CExprFunctionPtr &function, CExprValuePtr &value)
+executeStoreVariable(uint ind)
 {
-  std::deque<CExprValuePtr> values;
+  // rhs
+  auto value = unstackValue();
 
-  auto etoken = unstackEToken();
-  if (! etoken) return false;
+  CExprValuePtr result;
 
-  while (etoken->type() != CExprTokenType::OPERATOR) {
-    auto value1 = etokenToValue(etoken);
+  if (! storeVariable(ind, value, result))
+    return false;
 
-    values.push_front(value1);
+  stackValue(result);
 
-    etoken = unstackEToken();
-    assert(etoken);
+  return true;
+}
+
+bool
+CExprExecuteImpl::
+executeFunction(const CExprFunctionPtr &function, uint numArgs)
+{
+  if (numArgs > sp_)
+    return false;
+
+  CExprValuePtr result;
+
+  // typed function reads arguments from stack
+  if (function->isTyped() && numArgs == function->numArgs()) {
+    if (! function->execTyped(expr_, stack_.data() + sp_ - numArgs, result)) {
+      expr_->errorMsg("Invalid type for function argument");
+      return false;
+    }
+
+    for (uint i = 0; i < numArgs; ++i)
+      (void) unstackValue();
+
+    stackValue(result);
+
+    return true;
   }
 
-  for (uint i = 0; i < values.size(); ++i) {
-    auto value1 = values[i];
+  bool rc = callFunction(function, stack_.data() + sp_ - numArgs, numArgs, result);
 
-    auto argType = function->argType(i);
+  // argument values have been moved out of stack
+  sp_ -= numArgs;
 
-    if (! value1) {
-      if (! (uint(argType) & uint(CExprValueType::NUL))) {
-        expr_->errorMsg("Invalid type for function argument");
+  if (! rc)
+    return false;
+
+  stackValue(result);
+
+  return true;
+}
+
+//------------
+
+bool
+CExprExecuteImpl::
+executeRegisterCode(const CExprRegisterCode &code)
+{
+  registers_.resize(code.numRegisters());
+
+  bool rc = true;
+
+  const auto &instructions = code.instructions();
+
+  uint numInstructions = uint(instructions.size());
+
+  pc_ = 0;
+
+  while (pc_ < numInstructions) {
+    if (! executeRegisterInstruction(instructions[pc_++])) {
+      rc = false;
+      break;
+    }
+
+    if (expr_->getDebug()) {
+      std::cerr << "Registers:";
+      printRegisters(std::cerr);
+      std::cerr << "\n";
+    }
+  }
+
+  // result values to stack (undefined variable has no value)
+  if (rc) {
+    for (const auto &operand : code.results()) {
+      auto value = registerOperandValue(operand);
+
+      if (! value && operand.type == CExprRegOperand::Type::VAR) {
+        rc = false;
+        break;
+      }
+
+      stackValue(value);
+    }
+  }
+
+  // release intermediate values
+  for (auto &value : registers_)
+    value = CExprValuePtr();
+
+  return rc;
+}
+
+bool
+CExprExecuteImpl::
+executeRegisterInstruction(const CExprRegInstruction &instruction)
+{
+  CExprValuePtr result;
+
+  switch (instruction.code) {
+    case CExprOpCode::JUMP:
+      pc_ = instruction.arg;
+
+      return true;
+    case CExprOpCode::JUMP_IF_FALSE:
+    case CExprOpCode::JUMP_IF_TRUE: {
+      bool flag;
+
+      if (! conditionValue(instruction.op, registerOperandValue(instruction.lhs), flag))
+        return false;
+
+      if (flag == (instruction.code == CExprOpCode::JUMP_IF_TRUE))
+        pc_ = instruction.arg;
+
+      return true;
+    }
+    case CExprOpCode::MOVE:
+      result = registerOperandValue(instruction.lhs);
+      break;
+    case CExprOpCode::STORE_TEMP:
+      temps_[instruction.arg] = registerOperandValue(instruction.lhs);
+
+      return true;
+    case CExprOpCode::STORE_VAR:
+      if (! storeVariable(instruction.arg,
+                          registerOperandValue(instruction.lhs), result))
+        return false;
+      break;
+    case CExprOpCode::UNARY_OP:
+      if (! unaryOperator(instruction.op, registerOperandValue(instruction.lhs), result))
+        return false;
+      break;
+    case CExprOpCode::LOGICAL_UNARY_OP:
+      if (! logicalUnaryOperator(instruction.op, registerOperandValue(instruction.lhs), result))
         return false;
+      break;
+    case CExprOpCode::BITWISE_UNARY_OP:
+      if (! bitwiseUnaryOperator(instruction.op, registerOperandValue(instruction.lhs), result))
+        return false;
+      break;
+    case CExprOpCode::BINARY_OP:
+      if (! binaryOperator(instruction.op, registerOperandValue(instruction.lhs),
+                           registerOperandValue(instruction.rhs), result))
+        return false;
+      break;
+    case CExprOpCode::POWER_INT:
+      if (! powerIntegerOperator(registerOperandValue(instruction.lhs), instruction.arg, result))
+        return false;
+      break;
+    case CExprOpCode::UNARY_OP_I:
+    case CExprOpCode::UNARY_OP_R: {
+      auto value = registerOperandValue(instruction.lhs);
+
+      if (! typedUnaryOperator(instruction.code, instruction.op, value, result)) {
+        if (! unaryOperator(instruction.op, value, result))
+          return false;
       }
+
+      break;
     }
-    else {
-      if (! (uint(argType) & uint(CExprValueType::NUL))) {
-        if (! (uint(value1->getType()) & uint(argType)))
-          value1 = CExprValuePtr(value1->dup());
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI: {
+      auto value1 = registerOperandValue(instruction.lhs);
+      auto value2 = registerOperandValue(instruction.rhs);
+
+      if (! typedBinaryOperator(instruction.code, instruction.op, value1, value2, result)) {
+        if (! binaryOperator(instruction.op, value1, value2, result))
+          return false;
+      }
 
-        if (! value1->convToType(argType)) {
+      break;
+    }
+    case CExprOpCode::LOGICAL_BINARY_OP:
+      if (! logicalBinaryOperator(instruction.op, registerOperandValue(instruction.lhs),
+                                  registerOperandValue(instruction.rhs), result))
+        return false;
+      break;
+    case CExprOpCode::BITWISE_BINARY_OP:
+      if (! bitwiseBinaryOperator(instruction.op, registerOperandValue(instruction.lhs),
+                                  registerOperandValue(instruction.rhs), result))
+        return false;
+      break;
+    case CExprOpCode::CALL: {
+      const auto &function = program_->function(instruction.arg);
+
+      if (function->isTyped() && instruction.numArgs == function->numArgs()) {
+        if (! function->execTyped(expr_, registers_.data() + instruction.dst, result)) {
           expr_->errorMsg("Invalid type for function argument");
           return false;
         }
+
+        break;
       }
+
+      // argument registers are not used after call
+      if (! callFunction(function, registers_.data() + instruction.dst, instruction.numArgs,
+                         result))
+        return false;
+
+      break;
     }
+    default:
+      expr_->errorMsg("Invalid instruction for 'executeRegisterInstruction'");
+      return false;
   }
 
-  assert(etoken->type() == CExprTokenType::OPERATOR);
+  registers_[instruction.dst] = result;
+
+  return true;
+}
 
-  CExprValueArray values1;
+CExprValuePtr
+CExprExecuteImpl::
+registerOperandValue(const CExprRegOperand &operand) const
+{
+  switch (operand.type) {
+    case CExprRegOperand::Type::REG:
+      return registers_[operand.ind];
+    case CExprRegOperand::Type::TEMP:
+      return temps_[operand.ind];
+    case CExprRegOperand::Type::CONST:
+      return program_->value(operand.ind);
+    case CExprRegOperand::Type::VAR: {
+      auto variable = program_->variable(expr_, operand.ind);
 
-  std::copy(values.begin(), values.end(), std::back_inserter(values1));
+      if (variable)
+        return variable->getValue();
 
-  if (! function->checkValues(values1)) {
-    std::stringstream ostr;
-    ostr << "Invalid function values : ";
-    function->print(ostr);
-    expr_->errorMsg(ostr.str());
+      break;
+    }
+    default:
+      break;
+  }
+
+  return CExprValuePtr();
+}
+
+//------------
+
+bool
+CExprExecuteImpl::
+unaryOperator(CExprOpType type, CExprValuePtr value, CExprValuePtr &result)
+{
+  if (! value) return false;
+
+  result = value->execUnaryOp(expr_, type);
+
+  // increment/decrement of non-numeric value would store invalid value
+  if (! result && (type == CExprOpType::INCREMENT || type == CExprOpType::DECREMENT)) {
+    expr_->errorMsg("Invalid value for '" + expr_->getOperatorName(type) + "'");
     return false;
   }
 
-  value = function->exec(expr_, values1);
+  return true;
+}
+
+bool
+CExprExecuteImpl::
+logicalUnaryOperator(CExprOpType type, CExprValuePtr value, CExprValuePtr &result)
+{
+  if (! value) return false;
+
+  if (! value->isBooleanValue()) {
+    value = CExprValuePtr(value->dup());
+
+    if (! value->convToBoolean())
+      return true;
+  }
+
+  result = value->execUnaryOp(expr_, type);
 
   return true;
 }
 
 bool
 CExprExecuteImpl::
-executeBlock(const CExprTokenStack &stack, CExprValuePtr &value)
+bitwiseUnaryOperator(CExprOpType type, CExprValuePtr value, CExprValuePtr &result)
 {
-  CExprExecuteImpl impl(expr_);
+  if (! value) return false;
+
+  if (! value->isIntegerValue()) {
+    value = CExprValuePtr(value->dup());
+
+    if (! value->convToInteger())
+      return true;
+  }
+
+  result = value->execUnaryOp(expr_, type);
 
-  return impl.executeCTokenStack(stack, value);
+  return true;
 }
 
-CExprValuePtr
+bool
 CExprExecuteImpl::
-etokenToValue(const CExprTokenBaseP &etoken)
+binaryOperator(CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+               CExprValuePtr &result)
 {
-  switch (etoken->type()) {
-    case CExprTokenType::IDENTIFIER: {
-      auto varName = etoken->getIdentifier();
+  if (! value1 || ! value2)
+    return false;
 
-      auto variable = expr_->getVariable(varName);
+  bool convReal = false;
 
-      if (variable)
-        return variable->getValue();
+  if (value1->isRealValue() || value2->isRealValue())
+    convReal = true;
 
-      break;
+  if (! convReal && type == CExprOpType::DIVIDE && value2->isIntegerValue()) {
+    long l = 0;
+
+    value2->getIntegerValue(l);
+
+    if (l == 0)
+      convReal = true;
+  }
+
+  if (convReal) {
+    if (! value1->isRealValue()) value1 = CExprValuePtr(value1->dup());
+    if (! value2->isRealValue()) value2 = CExprValuePtr(value2->dup());
+
+    if (! value1->convToReal()) return false;
+    if (! value2->convToReal()) return false;
+  }
+
+  result = value1->execBinaryOp(expr_, value2, type);
+
+  return true;
+}
+
+bool
+CExprExecuteImpl::
+logicalBinaryOperator(CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+                      CExprValuePtr &result)
+{
+  if (! value1 || ! value2)
+    return false;
+
+  if (! value1->isBooleanValue()) {
+    value1 = CExprValuePtr(value1->dup());
+
+    if (! value1->convToBoolean())
+      return false;
+  }
+
+  if (! value2->isBooleanValue()) {
+    value2 = CExprValuePtr(value2->dup());
+
+    if (! value2->convToBoolean())
+      return false;
+  }
+
+  result = value1->execBinaryOp(expr_, value2, type);
+
+  return true;
+}
+
+bool
+CExprExecuteImpl::
+bitwiseBinaryOperator(CExprOpType type, CExprValuePtr value1, CExprValuePtr value2,
+                      CExprValuePtr &result)
+{
+  if (! value1 || ! value2)
+    return false;
+
+  if (! value1->isIntegerValue()) {
+    value1 = CExprValuePtr(value1->dup());
+
+    if (! value1->convToInteger())
+      return false;
+  }
+
+  if (! value2->isIntegerValue()) {
+    value2 = CExprValuePtr(value2->dup());
+
+    if (! value2->convToInteger())
+      return false;
+  }
+
+  result = value1->execBinaryOp(expr_, value2, type);
+
+  return true;
+}
+
+// unary operator on value of type given by opcode (false if value is different type)
+bool
+CExprExecuteImpl::
+typedUnaryOperator(CExprOpCode code, CExprOpType type, const CExprValuePtr &value,
+                   CExprValuePtr &result)
+{
+  if (! value) return false;
+
+  if      (code == CExprOpCode::UNARY_OP_I) {
+    if (! value->isType(CExprValueType::INTEGER)) return false;
+
+    long integer = value->integer();
+
+    switch (type) {
+      case CExprOpType::UNARY_PLUS : result = expr_->createIntegerValue( integer); break;
+      case CExprOpType::UNARY_MINUS: result = expr_->createIntegerValue(-integer); break;
+      case CExprOpType::INCREMENT  : result = expr_->createIntegerValue(integer + 1); break;
+      case CExprOpType::DECREMENT  : result = expr_->createIntegerValue(integer - 1); break;
+      default                      : return false;
     }
-    case CExprTokenType::FUNCTION: {
-      CExprValuePtr value;
+  }
+  else if (code == CExprOpCode::UNARY_OP_R) {
+    if (! value->isType(CExprValueType::REAL)) return false;
 
-      if (executeFunction(etoken->getFunction(), value))
-        return value;
+    double real = value->real();
 
-      break;
+    switch (type) {
+      case CExprOpType::UNARY_PLUS : result = expr_->createRealValue( real); break;
+      case CExprOpType::UNARY_MINUS: result = expr_->createRealValue(-real); break;
+      case CExprOpType::INCREMENT  : result = expr_->createRealValue(real + 1); break;
+      case CExprOpType::DECREMENT  : result = expr_->createRealValue(real - 1); break;
+      default                      : return false;
     }
-    case CExprTokenType::BLOCK: {
-      CExprValuePtr value;
+  }
+  else
+    return false;
+
+  return true;
+}
+
+// binary operator on values of types given by opcode (false if values are different
+// types). Mixed integer and real values are calculated as real
+bool
+CExprExecuteImpl::
+typedBinaryOperator(CExprOpCode code, CExprOpType type, const CExprValuePtr &value1,
+                    const CExprValuePtr &value2, CExprValuePtr &result)
+{
+  if (! value1 || ! value2) return false;
+
+  if (code == CExprOpCode::BINARY_OP_II) {
+    if (! value1->isType(CExprValueType::INTEGER) ||
+        ! value2->isType(CExprValueType::INTEGER))
+      return false;
+
+    long integer1 = value1->integer();
+    long integer2 = value2->integer();
+
+    switch (type) {
+      case CExprOpType::TIMES        : result = expr_->createIntegerValue(integer1 * integer2); break;
+      case CExprOpType::PLUS         : result = expr_->createIntegerValue(integer1 + integer2); break;
+      case CExprOpType::MINUS        : result = expr_->createIntegerValue(integer1 - integer2); break;
+      case CExprOpType::LESS         : result = expr_->createBooleanValue(integer1 <  integer2); break;
+      case CExprOpType::LESS_EQUAL   : result = expr_->createBooleanValue(integer1 <= integer2); break;
+      case CExprOpType::GREATER      : result = expr_->createBooleanValue(integer1 >  integer2); break;
+      case CExprOpType::GREATER_EQUAL: result = expr_->createBooleanValue(integer1 >= integer2); break;
+      case CExprOpType::EQUAL        : result = expr_->createBooleanValue(integer1 == integer2); break;
+      case CExprOpType::NOT_EQUAL    : result = expr_->createBooleanValue(integer1 != integer2); break;
+      default                        : return false;
+    }
+
+    return true;
+  }
+
+  double real1, real2;
+
+  switch (code) {
+    case CExprOpCode::BINARY_OP_RR:
+      if (! value1->isType(CExprValueType::REAL) || ! value2->isType(CExprValueType::REAL))
+        return false;
+
+      real1 = value1->real();
+      real2 = value2->real();
 
-      if (executeBlock(etoken->getBlock(), value))
-        return value;
+      break;
+    case CExprOpCode::BINARY_OP_IR:
+      if (! value1->isType(CExprValueType::INTEGER) || ! value2->isType(CExprValueType::REAL))
+        return false;
+
+      real1 = double(value1->integer());
+      real2 = value2->real();
+
+      break;
+    case CExprOpCode::BINARY_OP_RI:
+      if (! value1->isType(CExprValueType::REAL) || ! value2->isType(CExprValueType::INTEGER))
+        return false;
+
+      real1 = value1->real();
+      real2 = double(value2->integer());
 
       break;
+    default:
+      return false;
+  }
+
+  switch (type) {
+    case CExprOpType::TIMES        : result = expr_->createRealValue(real1 * real2); break;
+    case CExprOpType::DIVIDE       : result = expr_->createRealValue(real1 / real2); break;
+    case CExprOpType::PLUS         : result = expr_->createRealValue(real1 + real2); break;
+    case CExprOpType::MINUS        : result = expr_->createRealValue(real1 - real2); break;
+    case CExprOpType::LESS         : result = expr_->createBooleanValue(real1 <  real2); break;
+    case CExprOpType::LESS_EQUAL   : result = expr_->createBooleanValue(real1 <= real2); break;
+    case CExprOpType::GREATER      : result = expr_->createBooleanValue(real1 >  real2); break;
+    case CExprOpType::GREATER_EQUAL: result = expr_->createBooleanValue(real1 >= real2); break;
+    case CExprOpType::EQUAL        : result = expr_->createBooleanValue(real1 == real2); break;
+    case CExprOpType::NOT_EQUAL    : result = expr_->createBooleanValue(real1 != real2); break;
+    default                        : return false;
+  }
+
+  return true;
+}
+
+// value raised to constant integer power (generic operator if not integer or real
+// value or power fails)
+bool
+CExprExecuteImpl::
+powerIntegerOperator(const CExprValuePtr &value, uint exponent, CExprValuePtr &result)
+{
+  int error_code = 0;
+
+  if      (value && value->isType(CExprValueType::INTEGER)) {
+    long integer = CExprIntegerValue::integerPower(value->integer(), long(exponent), &error_code);
+
+    if (error_code == 0) {
+      result = expr_->createIntegerValue(integer);
+      return true;
     }
-    case CExprTokenType::VALUE:
-      return etoken->getValue();
+  }
+  else if (value && value->isType(CExprValueType::REAL)) {
+    double real = CExprRealValue::realIntegerPower(value->real(), long(exponent), &error_code);
+
+    if (error_code == 0) {
+      result = expr_->createRealValue(real);
+      return true;
+    }
+  }
+
+  return binaryOperator(CExprOpType::POWER, value, expr_->createIntegerValue(long(exponent)),
+                        result);
+}
+
+// binary operator for binary opcode (typed opcodes use generic operator if values are
+// different types)
+bool
+CExprExecuteImpl::
+binaryCodeOperator(CExprOpCode code, CExprOpType type, const CExprValuePtr &value1,
+                   const CExprValuePtr &value2, CExprValuePtr &result)
+{
+  switch (code) {
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      if (typedBinaryOperator(code, type, value1, value2, result))
+        return true;
+
+      return binaryOperator(type, value1, value2, result);
+    case CExprOpCode::BINARY_OP:
+      return binaryOperator(type, value1, value2, result);
+    case CExprOpCode::LOGICAL_BINARY_OP:
+      return logicalBinaryOperator(type, value1, value2, result);
+    case CExprOpCode::BITWISE_BINARY_OP:
+      return bitwiseBinaryOperator(type, value1, value2, result);
     default:
-      break;
+      expr_->errorMsg("Invalid binary opcode");
+      return false;
   }
+}
 
-  return CExprValuePtr();
+// boolean value of condition. For ?: a value which is not convertible is false,
+// for && and || it is an error (as for other logical operators)
+bool
+CExprExecuteImpl::
+conditionValue(CExprOpType type, const CExprValuePtr &value, bool &flag)
+{
+  if (! value) return false;
+
+  if (! value->getBooleanValue(flag)) {
+    if (type != CExprOpType::QUESTION)
+      return false;
+
+    flag = false;
+  }
+
+  return true;
 }
 
-void
+bool
 CExprExecuteImpl::
-stackValue(const CExprValuePtr &value)
+storeVariable(uint ind, const CExprValuePtr &value, CExprValuePtr &result)
 {
-  if (! value) return;
+  if (! value) return false;
+
+  const auto &variable = program_->variable(expr_, ind);
+
+  if (variable) {
+    if (! variable->setValue(value)) {
+      expr_->errorMsg("Invalid value for variable '" + variable->name() + "'");
+      return false;
+    }
+
+    result = variable->getValue();
+  }
+  else {
+    // assignment creates variable
+    auto variable1 = expr_->createVariable(program_->identifier(ind), value);
+
+    program_->setVariable(ind, variable1);
 
-  CExprTokenBaseP base(CExprTokenMgrInst->createValueToken(value));
+    result = variable1->getValue();
+  }
 
-  stackEToken(base);
+  return true;
 }
 
-void
+// call function with argument values moved from consecutive stack values or registers
+bool
 CExprExecuteImpl::
-stackBlock()
+callFunction(const CExprFunctionPtr &function, CExprValuePtr *args, uint numArgs,
+             CExprValuePtr &result)
 {
-  CExprTokenStack stack;
+  // argument array storage is reused between calls (taken while in use as function can
+  // execute nested calls)
+  CExprValueArray values;
 
-  long brackets = 1;
+  values.swap(args_);
 
-  while (ctokenPos_ < numCTokens_) {
-    auto ctoken = ctokenStack_.getToken(ctokenPos_++);
+  values.resize(numArgs);
 
-    if (! ctoken)
-      break;
+  for (uint i = 0; i < numArgs; ++i)
+    values[i] = std::move(args[i]);
+
+  bool rc = callFunction(function, values, result);
+
+  values.clear();
+
+  args_.swap(values);
+
+  return rc;
+}
 
-    if (ctoken->type() == CExprTokenType::OPERATOR) {
-      auto op = ctoken->getOperator();
+bool
+CExprExecuteImpl::
+callFunction(const CExprFunctionPtr &function, CExprValueArray &values, CExprValuePtr &result)
+{
+  uint numArgs = uint(values.size());
 
-      if      (op == CExprOpType::START_BLOCK)
-        ++brackets;
-      else if (op == CExprOpType::END_BLOCK) {
-        --brackets;
+  for (uint i = 0; i < numArgs; ++i) {
+    auto &value1 = values[i];
 
-        if (brackets <= 0)
-          break;
+    auto argType = function->argType(i);
+
+    if (! value1) {
+      if (! (uint(argType) & uint(CExprValueType::NUL))) {
+        expr_->errorMsg("Invalid type for function argument");
+        return false;
       }
     }
+    else {
+      if (! (uint(argType) & uint(CExprValueType::NUL))) {
+        if (uint(value1->getType()) & uint(argType))
+          continue;
+
+        // convert in place if argument is only reference to non-constant value
+        if (! value1.isUnique() || value1->isConstant())
+          value1 = expr_->dupValue(*value1);
 
-    stack.addToken(ctoken);
+        if (! value1->convToType(argType)) {
+          expr_->errorMsg("Invalid type for function argument");
+          return false;
+        }
+      }
+    }
+  }
+
+  if (! function->checkValues(values)) {
+    std::stringstream ostr;
+    ostr << "Invalid function values : ";
+    function->print(ostr);
+    expr_->errorMsg(ostr.str());
+    return false;
   }
 
-  CExprTokenBaseP base(new CExprTokenBlock(stack));
+  result = function->exec(expr_, values);
 
-  stackEToken(base);
+  return true;
 }
 
+//------------
+
 void
 CExprExecuteImpl::
-stackEToken(const CExprTokenBaseP &base)
+stackValue(const CExprValuePtr &value)
 {
-  etokenStack_.addToken(base);
+  // only grows if program max depth is wrong
+  if (sp_ >= stack_.size())
+    stack_.resize(sp_ + 1);
+
+  stack_[sp_++] = value;
 }
 
 CExprValuePtr
 CExprExecuteImpl::
 unstackValue()
 {
-  auto etoken = unstackEToken();
-  if (! etoken) return CExprValuePtr();
+  if (sp_ == 0)
+    return CExprValuePtr();
 
-  return etokenToValue(etoken);
+  return std::move(stack_[--sp_]);
 }
 
-CExprTokenBaseP
+// release stack values (keeps stack storage)
+void
 CExprExecuteImpl::
-unstackEToken()
+clearStack()
 {
-  auto etoken = etokenStack_.pop_back();
+  for (uint i = 0; i < sp_; ++i)
+    stack_[i] = CExprValuePtr();
+
+  sp_ = 0;
+}
 
-  return etoken;
+void
+CExprExecuteImpl::
+printStack(std::ostream &os) const
+{
+  for (uint i = 0; i < sp_; ++i) {
+    if (stack_[i])
+      os << " " << *stack_[i];
+    else
+      os << " <null>";
+  }
+}
+
+void
+CExprExecuteImpl::
+printRegisters(std::ostream &os) const
+{
+  for (const auto &value : registers_) {
+    if (value)
+      os << " " << *value;
+    else
+      os << " <null>";
+  }
 }
@@ -1,10 +1,12 @@
 #include <CExprI.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 
 struct CExprBuiltinFunction {
   const char        *name;
   const char        *args;
+  CExprValueType     result;
   CExprFunctionProc  proc;
 };
 
@@ -68,18 +70,18 @@ CEXPR_REAL_INTEGER_1_FUNC(Abs, ::fabs, std::abs)
 
 static CExprBuiltinFunction
 builtinFns[] = {
-  { "sqrt" , "r" , CExprFunctionSqrt  },
-  { "exp"  , "r" , CExprFunctionExp   },
-  { "log"  , "r" , CExprFunctionLog   },
-  { "log10", "r" , CExprFunctionLog10 },
-  { "sin"  , "r" , CExprFunctionSin   },
-  { "cos"  , "r" , CExprFunctionCos   },
-  { "tan"  , "r" , CExprFunctionTan   },
-  { "abs"  , "ri", CExprFunctionAbs   },
-  { "asin" , "r" , CExprFunctionASin  },
-  { "acos" , "r" , CExprFunctionACos  },
-  { "atan" , "r" , CExprFunctionATan  },
-  { ""     , ""  , nullptr            }
+  { "sqrt" , "r" , CExprValueType::REAL, CExprFunctionSqrt  },
+  { "exp"  , "r" , CExprValueType::REAL, CExprFunctionExp   },
+  { "log"  , "r" , CExprValueType::REAL, CExprFunctionLog   },
+  { "log10", "r" , CExprValueType::REAL, CExprFunctionLog10 },
+  { "sin"  , "r" , CExprValueType::REAL, CExprFunctionSin   },
+  { "cos"  , "r" , CExprValueType::REAL, CExprFunctionCos   },
+  { "tan"  , "r" , CExprValueType::REAL, CExprFunctionTan   },
+  { "abs"  , "ri", CExprValueType::NONE, CExprFunctionAbs   },
+  { "asin" , "r" , CExprValueType::REAL, CExprFunctionASin  },
+  { "acos" , "r" , CExprValueType::REAL, CExprFunctionACos  },
+  { "atan" , "r" , CExprValueType::REAL, CExprFunctionATan  },
+  { ""     , ""  , CExprValueType::NONE, nullptr            }
 };
 
 //------
@@ -103,6 +105,8 @@ addFunctions()
     auto function = addProcFunction(builtinFns[i].name, builtinFns[i].args, builtinFns[i].proc);
 
     function->setBuiltin(true);
+    function->setPure(true);
+    function->setResultType(builtinFns[i].result);
   }
 }
 
@@ -110,20 +114,44 @@ CExprFunctionPtr
 CExprFunctionMgr::
 getFunction(const std::string &name)
 {
-  for (const auto &func : functions_)
-    if (func->name() == name)
-      return func;
+  auto p = nameMap_.find(name);
+
+  if (p == nameMap_.end())
+    return CExprFunctionPtr();
 
-  return CExprFunctionPtr();
+  return *(*p).second.positions.front();
 }
 
 void
 CExprFunctionMgr::
 getFunctions(const std::string &name, Functions &functions)
 {
-  for (const auto &func : functions_)
-    if (func->name() == name)
-      functions.push_back(func);
+  auto p = nameMap_.find(name);
+
+  if (p == nameMap_.end())
+    return;
+
+  for (const auto &pos : (*p).second.positions)
+    functions.push_back(*pos);
+}
+
+CExprFunctionPtr
+CExprFunctionMgr::
+findFunction(const std::string &name, uint numArgs)
+{
+  auto p = nameMap_.find(name);
+
+  if (p == nameMap_.end())
+    return CExprFunctionPtr();
+
+  const auto &nameFunctions = (*p).second;
+
+  auto pa = nameFunctions.arityFunctions.find(numArgs);
+
+  if (pa != nameFunctions.arityFunctions.end())
+    return (*pa).second.front();
+
+  return *nameFunctions.positions.back();
 }
 
 CExprFunctionPtr
@@ -135,15 +163,13 @@ addProcFunction(const std::string &name, const std::string &argsStr, CExprFuncti
 
   (void) parseArgs(argsStr, args, variableArgs);
 
-  auto function = std::make_shared<CExprProcFunction>(name, args, proc);
+  auto function = CExprFunctionPtr(new CExprProcFunction(name, args, proc));
 
   function->setVariableArgs(variableArgs);
 
   removeFunction(name);
 
-  functions_.push_back(function);
-
-  resetCompiled();
+  addFunction(function);
 
   return function;
 }
@@ -157,32 +183,41 @@ addObjFunction(const std::string &name, const std::string &argsStr, CExprFunctio
 
   (void) parseArgs(argsStr, args, variableArgs);
 
-  auto function = std::make_shared<CExprObjFunction>(name, args, proc);
+  auto function = CExprFunctionPtr(new CExprObjFunction(name, args, proc));
 
   function->setVariableArgs(variableArgs);
 
   if (! proc->isOverload())
     removeFunction(name);
 
-  functions_.push_back(function);
-
-  resetCompiled();
+  addFunction(function);
 
   return function;
 }
 
+CExprFunctionPtr
+CExprFunctionMgr::
+addTypedFunction(CExprFunction *function)
+{
+  auto function1 = CExprFunctionPtr(function);
+
+  removeFunction(function1->name());
+
+  addFunction(function1);
+
+  return function1;
+}
+
 CExprFunctionPtr
 CExprFunctionMgr::
 addUserFunction(const std::string &name, const std::vector<std::string> &args,
                 const std::string &proc)
 {
-  auto function = std::make_shared<CExprUserFunction>(name, args, proc);
+  auto function = CExprFunctionPtr(new CExprUserFunction(name, args, proc));
 
   removeFunction(name);
 
-  functions_.push_back(function);
-
-  resetCompiled();
+  addFunction(function);
 
   return function;
 }
@@ -198,8 +233,59 @@ void
 CExprFunctionMgr::
 removeFunction(CExprFunctionPtr function)
 {
-  if (function)
-    functions_.remove(function);
+  if (! function)
+    return;
+
+  auto p = nameMap_.find(function->name());
+
+  if (p == nameMap_.end())
+    return;
+
+  auto &nameFunctions = (*p).second;
+
+  auto &positions = nameFunctions.positions;
+
+  for (auto pp = positions.begin(); pp != positions.end(); ++pp) {
+    if (**pp != function)
+      continue;
+
+    functions_.erase(*pp);
+
+    positions.erase(pp);
+
+    break;
+  }
+
+  auto pa = nameFunctions.arityFunctions.find(function->numArgs());
+
+  if (pa != nameFunctions.arityFunctions.end()) {
+    auto &functions = (*pa).second;
+
+    functions.erase(std::find(functions.begin(), functions.end(), function));
+
+    if (functions.empty())
+      nameFunctions.arityFunctions.erase(pa);
+  }
+
+  if (positions.empty())
+    nameMap_.erase(p);
+
+  resetCompiled();
+}
+
+void
+CExprFunctionMgr::
+addFunction(CExprFunctionPtr function)
+{
+  auto pos = functions_.insert(functions_.end(), function);
+
+  auto &nameFunctions = nameMap_[function->name()];
+
+  nameFunctions.positions.push_back(pos);
+
+  nameFunctions.arityFunctions[function->numArgs()].push_back(function);
+
+  resetCompiled();
 }
 
 void
@@ -214,8 +300,8 @@ void
 CExprFunctionMgr::
 resetCompiled()
 {
-  for (const auto &func : functions_)
-    func->reset();
+  // user functions compile again when used
+  ++generation_;
 }
 
 bool
@@ -344,11 +430,39 @@ reset()
   compiled_ = false;
 
   pstack_.clear();
-  cstack_.clear();
+  program_.clear();
 
   itoken_ = CExprITokenPtr();
 }
 
+bool
+CExprUserFunction::
+compile(CExpr *expr) const
+{
+  if (compiled_ && generation_ == expr->functionGeneration())
+    return true;
+
+  if (compiling_)
+    return false;
+
+  compiling_  = true;
+  generation_ = expr->functionGeneration();
+
+  // body can be compiled while compiling caller
+  expr->saveCompileState();
+
+  pstack_  = expr->parseLine(proc_);
+  itoken_  = expr->interpPTokenStack(pstack_);
+  program_ = expr->compileIToken(itoken_, args_);
+
+  expr->restoreCompileState();
+
+  compiling_ = false;
+  compiled_  = true;
+
+  return true;
+}
+
 CExprValuePtr
 CExprUserFunction::
 exec(CExpr *expr, const CExprValueArray &values)
@@ -357,35 +471,26 @@ exec(CExpr *expr, const CExprValueArray &values)
 
   //---
 
-  if (! compiled_) {
-    pstack_ = expr->parseLine(proc_);
-    itoken_ = expr->interpPTokenStack(pstack_);
-    cstack_ = expr->compileIToken(itoken_);
-
-    compiled_ = true;
-  }
+  (void) compile(expr);
 
   //---
 
-  typedef std::map<std::string,CExprValuePtr> VarValues;
-
-  VarValues varValues;
+  // arg values hide variables of same name (bound memory and variable objects are not
+  // changed)
+  ArgVariables argVariables(numArgs());
 
-  // set arg values (save previous values)
   for (uint i = 0; i < numArgs(); ++i) {
     const auto &arg = args_[i];
 
-    auto var = expr->getVariable(arg);
+    auto &argVariable = argVariables[i];
 
-    if (var) {
-      varValues[arg] = var->getValue();
+    argVariable.variable = expr->getVariable(arg);
 
-      var->setValue(values[i]);
-    }
+    if (argVariable.variable)
+      argVariable.variable->shadow(values[i], argVariable.shadow);
     else {
-      varValues[arg] = CExprValuePtr();
-
-      expr->createVariable(arg, values[i]);
+      argVariable.variable = expr->createVariable(arg, values[i]);
+      argVariable.created  = true;
     }
   }
 
@@ -398,23 +503,19 @@ exec(CExpr *expr, const CExprValueArray &values)
 //  value = CExprValuePtr();
 //if (! expr->executePTokenStack(pstack_, value))
 //  value = CExprValuePtr();
-  if (! expr->executeCTokenStack(cstack_, value))
+  if (! expr->executeProgram(program_, value))
     value = CExprValuePtr();
 
   expr->restoreCompileState();
 
-  // restore variables
-  for (const auto &v : varValues) {
-    const auto &varName = v.first;
-    auto        value1  = v.second;
+  // restore variables (in reverse order for repeated arg names)
+  for (uint i = numArgs(); i > 0; --i) {
+    const auto &argVariable = argVariables[i - 1];
 
-    if (value1) {
-      auto var = expr->getVariable(varName);
-
-      var->setValue(value1);
-    }
+    if (argVariable.created)
+      expr->removeVariable(args_[i - 1]);
     else
-      expr->removeVariable(varName);
+      argVariable.variable->unshadow(argVariable.shadow);
   }
 
   return value;
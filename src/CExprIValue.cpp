@@ -1,6 +1,29 @@
 #include <CExprI.h>
 #include <cerrno>
 #include <cmath>
+#include <climits>
+
+// multiply integers (true if result overflows)
+static bool
+mulOverflow(long integer1, long integer2, long *result)
+{
+#ifdef __GNUC__
+  return __builtin_mul_overflow(integer1, integer2, result);
+#else
+  if (integer1 > 0) {
+    if (integer2 > 0 ? integer1 > LONG_MAX/integer2 : integer2 < LONG_MIN/integer1)
+      return true;
+  }
+  else if (integer1 < 0) {
+    if (integer2 > 0 ? integer1 < LONG_MIN/integer2 : integer2 < LONG_MAX/integer1)
+      return true;
+  }
+
+  *result = integer1*integer2;
+
+  return false;
+#endif
+}
 
 bool
 CExprIntegerValue::
@@ -20,6 +43,10 @@ execUnaryOp(CExpr *expr, CExprOpType op) const
       return expr->createIntegerValue(integer_);
     case CExprOpType::UNARY_MINUS:
       return expr->createIntegerValue(-integer_);
+    case CExprOpType::INCREMENT:
+      return expr->createIntegerValue(integer_ + 1);
+    case CExprOpType::DECREMENT:
+      return expr->createIntegerValue(integer_ - 1);
     case CExprOpType::BIT_NOT:
       return expr->createIntegerValue(~integer_);
     default:
@@ -29,7 +56,7 @@ execUnaryOp(CExpr *expr, CExprOpType op) const
 
 CExprValuePtr
 CExprIntegerValue::
-execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
+execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const
 {
   long irhs;
 
@@ -40,6 +67,16 @@ execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
     case CExprOpType::POWER: {
       int error_code;
 
+      // negative power is real
+      if (irhs < 0) {
+        double real = CExprRealValue::realPower(double(integer_), double(irhs), &error_code);
+
+        if (error_code != 0)
+          return CExprValuePtr();
+        else
+          return expr->createRealValue(real);
+      }
+
       long integer = integerPower(integer_, irhs, &error_code);
 
       if (error_code != 0)
@@ -96,37 +133,39 @@ execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
   }
 }
 
+// exact integer power by repeated squaring (error if power is negative or
+// result overflows)
 long
 CExprIntegerValue::
-integerPower(long integer1, long integer2, int *error_code) const
+integerPower(long integer1, long integer2, int *error_code)
 {
   *error_code = 0;
 
-  if (integer1 == 0 && integer2 < 0) {
-    *error_code = int(CExprErrorType::ZERO_TO_NEG_POWER_UNDEF);
+  if (integer2 < 0) {
+    *error_code = int(CExprErrorType::POWER_FAILED);
     return 0;
   }
 
-  double real;
+  long result = 1;
+  long base   = integer1;
 
-  errno = 0;
+  while (integer2 > 0) {
+    if (integer2 & 1) {
+      if (mulOverflow(result, base, &result)) {
+        *error_code = int(CExprErrorType::POWER_FAILED);
+        return 0;
+      }
+    }
 
-  if (integer2 < 0)
-    real = 1.0/pow(double(integer1), double(-integer2));
-  else
-    real = pow(double(integer1), double(integer2));
+    integer2 >>= 1;
 
-  if (errno != 0) {
-    *error_code = int(CExprErrorType::POWER_FAILED);
-    return 0;
+    if (integer2 > 0 && mulOverflow(base, base, &base)) {
+      *error_code = int(CExprErrorType::POWER_FAILED);
+      return 0;
+    }
   }
 
-  long integer = realToInteger(real, error_code);
-
-  if (*error_code != 0)
-    return 0;
-
-  return integer;
+  return result;
 }
 
 long
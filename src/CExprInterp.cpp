@@ -1468,7 +1468,9 @@ printTrackBack(std::ostream &os)
   for (uint i = 0; i < size; ++i) {
     auto ptoken = ptokenStack_.getToken(i);
 
-    os << " " << ptoken;
+    os << " ";
+
+    ptoken->print(os);
   }
 
   os << "\n";
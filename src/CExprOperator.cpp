@@ -74,8 +74,6 @@ operator_data[] = {
   { CExprOpType::BIT_LSHIFT_EQUALS, "<<="  , },
   { CExprOpType::BIT_RSHIFT_EQUALS, ">>="  , },
   { CExprOpType::COMMA            , ","    , },
-  { CExprOpType::START_BLOCK      , "{"    , },
-  { CExprOpType::END_BLOCK        , "}"    , },
   { CExprOpType::UNKNOWN          , nullptr, }
 };
 
@@ -0,0 +1,180 @@
+#include <CExprI.h>
+
+bool
+CExprPeephole::
+optimize(CExprProgram &program)
+{
+  uint numInstructions = program.numInstructions();
+
+  // instructions which are jump targets can't be inside fused sequence
+  Targets isTarget(numInstructions + 1, false);
+
+  for (const auto &instruction : program.instructions()) {
+    if (CExprProgram::isJump(instruction.code))
+      isTarget[instruction.arg1] = true;
+  }
+
+  Instructions      instructions;
+  std::vector<uint> newIndex(numInstructions + 1, 0);
+
+  bool changed = false;
+
+  uint i = 0;
+
+  while (i < numInstructions) {
+    newIndex[i] = uint(instructions.size());
+
+    CExprInstruction fused;
+
+    uint len = fuseInstructions(program, i, isTarget, fused);
+
+    if (len > 0) {
+      for (uint j = 1; j < len; ++j)
+        newIndex[i + j] = newIndex[i];
+
+      instructions.push_back(fused);
+
+      addCount(fused);
+
+      changed = true;
+
+      i += len;
+    }
+    else {
+      instructions.push_back(program.instruction(i));
+
+      ++i;
+    }
+  }
+
+  if (! changed)
+    return false;
+
+  newIndex[numInstructions] = uint(instructions.size());
+
+  for (auto &instruction : instructions) {
+    if (CExprProgram::isJump(instruction.code))
+      instruction.arg1 = newIndex[instruction.arg1];
+  }
+
+  program.setInstructions(instructions);
+
+  return true;
+}
+
+// fused instruction for instructions starting at i (returns number of instructions
+// replaced or zero if no match)
+uint
+CExprPeephole::
+fuseInstructions(const CExprProgram &program, uint i, const Targets &isTarget,
+                 CExprInstruction &fused) const
+{
+  uint numInstructions = program.numInstructions();
+
+  const auto &instruction1 = program.instruction(i);
+
+  // load(a) push(c)|load(b) <binary>
+  if (i + 2 < numInstructions && ! isTarget[i + 1] && ! isTarget[i + 2]) {
+    const auto &instruction2 = program.instruction(i + 1);
+    const auto &instruction3 = program.instruction(i + 2);
+
+    if (instruction1.code == CExprOpCode::LOAD_VAR && isBinaryOpCode(instruction3.code)) {
+      if      (instruction2.code == CExprOpCode::PUSH_VALUE)
+        fused.code = CExprOpCode::BINARY_VAR_CONST;
+      else if (instruction2.code == CExprOpCode::LOAD_VAR)
+        fused.code = CExprOpCode::BINARY_VAR_VAR;
+      else
+        fused.code = CExprOpCode::NOP;
+
+      if (fused.code != CExprOpCode::NOP) {
+        fused.op    = instruction3.op;
+        fused.arg1  = instruction1.arg1;
+        fused.arg2  = instruction2.arg1;
+        fused.fused = instruction3.code;
+
+        return 3;
+      }
+    }
+  }
+
+  // <compare> jump_if_false|jump_if_true
+  if (i + 1 < numInstructions && ! isTarget[i + 1]) {
+    const auto &instruction2 = program.instruction(i + 1);
+
+    if (isBinaryOpCode(instruction1.code) && isCompareOp(instruction1.op)) {
+      if      (instruction2.code == CExprOpCode::JUMP_IF_FALSE)
+        fused.code = CExprOpCode::BINARY_JUMP_IF_FALSE;
+      else if (instruction2.code == CExprOpCode::JUMP_IF_TRUE)
+        fused.code = CExprOpCode::BINARY_JUMP_IF_TRUE;
+      else
+        fused.code = CExprOpCode::NOP;
+
+      if (fused.code != CExprOpCode::NOP) {
+        fused.op    = instruction1.op;
+        fused.arg1  = instruction2.arg1;
+        fused.arg2  = uint(instruction2.op);
+        fused.fused = instruction1.code;
+
+        return 2;
+      }
+    }
+  }
+
+  return 0;
+}
+
+bool
+CExprPeephole::
+isBinaryOpCode(CExprOpCode code)
+{
+  switch (code) {
+    case CExprOpCode::BINARY_OP:
+    case CExprOpCode::LOGICAL_BINARY_OP:
+    case CExprOpCode::BITWISE_BINARY_OP:
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// comparison result is always boolean so branch has same result for any jump op
+bool
+CExprPeephole::
+isCompareOp(CExprOpType op)
+{
+  switch (op) {
+    case CExprOpType::LESS:
+    case CExprOpType::LESS_EQUAL:
+    case CExprOpType::GREATER:
+    case CExprOpType::GREATER_EQUAL:
+    case CExprOpType::EQUAL:
+    case CExprOpType::NOT_EQUAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void
+CExprPeephole::
+addCount(const CExprInstruction &fused)
+{
+  std::string name = CExprProgram::opCodeName(fused.code);
+
+  name += "(" + std::string(CExprProgram::opCodeName(fused.fused)) + " " +
+          expr_->getOperatorName(fused.op) + ")";
+
+  ++counts_[name];
+}
+
+void
+CExprPeephole::
+printCounts(std::ostream &os) const
+{
+  for (const auto &count : counts_)
+    os << count.first << " " << count.second << "\n";
+}
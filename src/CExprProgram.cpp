@@ -0,0 +1,353 @@
+#include <CExprI.h>
+#include <algorithm>
+
+uint
+CExprProgram::
+addInstruction(const CExprInstruction &instruction)
+{
+  instructions_.push_back(instruction);
+
+  instructionsChanged();
+
+  depth_ += stackEffect(instruction);
+
+  if (depth_ > int(maxDepth_))
+    maxDepth_ = uint(depth_);
+
+  return uint(instructions_.size() - 1);
+}
+
+uint
+CExprProgram::
+addValue(const CExprValuePtr &value)
+{
+  values_.push_back(value);
+
+  return uint(values_.size() - 1);
+}
+
+uint
+CExprProgram::
+addIdentifier(const std::string &name)
+{
+  auto n = identifiers_.size();
+
+  for (uint i = 0; i < n; ++i)
+    if (identifiers_[i] == name)
+      return i;
+
+  identifiers_.push_back(name);
+  variables_  .push_back(CExprVariablePtr());
+
+  return uint(n);
+}
+
+const CExprVariablePtr &
+CExprProgram::
+variable(CExpr *expr, uint i) const
+{
+  auto &variable = variables_[i];
+
+  if (! variable || variable->isRemoved())
+    variable = expr->getVariable(identifiers_[i]);
+
+  return variable;
+}
+
+void
+CExprProgram::
+setVariable(uint i, const CExprVariablePtr &variable) const
+{
+  variables_[i] = variable;
+}
+
+void
+CExprProgram::
+bindVariables(CExpr *expr) const
+{
+  for (uint i = 0; i < identifiers_.size(); ++i)
+    variables_[i] = expr->getVariable(identifiers_[i]);
+}
+
+uint
+CExprProgram::
+addFunction(const CExprFunctionPtr &function)
+{
+  auto n = functions_.size();
+
+  for (uint i = 0; i < n; ++i)
+    if (functions_[i] == function)
+      return i;
+
+  functions_.push_back(function);
+
+  return uint(n);
+}
+
+bool
+CExprProgram::
+hasFunction(const std::string &name) const
+{
+  for (const auto &function : functions_)
+    if (function->name() == name)
+      return true;
+
+  return false;
+}
+
+void
+CExprProgram::
+setOpCode(uint i, CExprOpCode code)
+{
+  assert(i < instructions_.size());
+
+  instructions_[i].code = code;
+
+  instructionsChanged();
+}
+
+void
+CExprProgram::
+setInstructions(const Instructions &instructions)
+{
+  instructions_ = instructions;
+
+  instructionsChanged();
+}
+
+void
+CExprProgram::
+removeLastInstruction()
+{
+  assert(! instructions_.empty());
+
+  const auto &instruction = instructions_.back();
+
+  depth_ -= stackEffect(instruction);
+
+  if (instruction.code == CExprOpCode::PUSH_VALUE && instruction.arg1 == values_.size() - 1)
+    values_.pop_back();
+
+  instructions_.pop_back();
+
+  instructionsChanged();
+}
+
+void
+CExprProgram::
+setJumpTarget(uint i, uint target)
+{
+  assert(isJump(instructions_[i].code));
+
+  instructions_[i].arg1 = target;
+
+  instructionsChanged();
+
+  lastJumpTarget_ = std::max(lastJumpTarget_, target);
+}
+
+bool
+CExprProgram::
+isJump(CExprOpCode code)
+{
+  return (code == CExprOpCode::JUMP ||
+          code == CExprOpCode::JUMP_IF_FALSE ||
+          code == CExprOpCode::JUMP_IF_TRUE ||
+          code == CExprOpCode::BINARY_JUMP_IF_FALSE ||
+          code == CExprOpCode::BINARY_JUMP_IF_TRUE);
+}
+
+// change in operand stack size after instruction is executed
+int
+CExprProgram::
+stackEffect(const CExprInstruction &instruction)
+{
+  switch (instruction.code) {
+    case CExprOpCode::PUSH_VALUE:
+    case CExprOpCode::PUSH_NULL:
+    case CExprOpCode::LOAD_VAR:
+    case CExprOpCode::LOAD_TEMP:
+    case CExprOpCode::BINARY_VAR_CONST:
+    case CExprOpCode::BINARY_VAR_VAR:
+      return 1;
+    case CExprOpCode::POP:
+    case CExprOpCode::JUMP_IF_FALSE:
+    case CExprOpCode::JUMP_IF_TRUE:
+    case CExprOpCode::BINARY_OP:
+    case CExprOpCode::LOGICAL_BINARY_OP:
+    case CExprOpCode::BITWISE_BINARY_OP:
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      return -1;
+    case CExprOpCode::BINARY_JUMP_IF_FALSE:
+    case CExprOpCode::BINARY_JUMP_IF_TRUE:
+      return -2;
+    case CExprOpCode::CALL:
+      return 1 - int(instruction.arg2);
+    default:
+      return 0;
+  }
+}
+
+bool
+CExprProgram::
+buildRegisterCode()
+{
+  registerCode_.reset();
+
+  auto registerCode = std::make_shared<CExprRegisterCode>();
+
+  if (! registerCode->build(*this))
+    return false;
+
+  registerCode_ = registerCode;
+
+  return true;
+}
+
+// derived forms of instructions (threaded dispatch handlers and register code)
+// must be built again
+void
+CExprProgram::
+instructionsChanged()
+{
+  handlersResolved_ = false;
+
+  registerCode_.reset();
+}
+
+void
+CExprProgram::
+clear()
+{
+  instructions_.clear();
+  values_      .clear();
+  identifiers_ .clear();
+  variables_   .clear();
+  functions_   .clear();
+
+  depth_          = 0;
+  maxDepth_       = 0;
+  lastJumpTarget_ = 0;
+  numFolded_      = 0;
+  numTemps_       = 0;
+
+  instructionsChanged();
+}
+
+void
+CExprProgram::
+print(std::ostream &os) const
+{
+  bool first = true;
+
+  for (const auto &instruction : instructions_) {
+    if (! first) os << " ";
+
+    printInstruction(os, instruction);
+
+    first = false;
+  }
+}
+
+void
+CExprProgram::
+printInstruction(std::ostream &os, const CExprInstruction &instruction) const
+{
+  os << opCodeName(instruction.code);
+
+  switch (instruction.code) {
+    case CExprOpCode::PUSH_VALUE:
+      os << "(" << *values_[instruction.arg1] << ")";
+      break;
+    case CExprOpCode::LOAD_VAR:
+    case CExprOpCode::STORE_VAR:
+      os << "(" << identifiers_[instruction.arg1] << ")";
+      break;
+    case CExprOpCode::UNARY_OP:
+    case CExprOpCode::LOGICAL_UNARY_OP:
+    case CExprOpCode::BITWISE_UNARY_OP:
+    case CExprOpCode::BINARY_OP:
+    case CExprOpCode::LOGICAL_BINARY_OP:
+    case CExprOpCode::BITWISE_BINARY_OP:
+    case CExprOpCode::UNARY_OP_I:
+    case CExprOpCode::UNARY_OP_R:
+    case CExprOpCode::BINARY_OP_II:
+    case CExprOpCode::BINARY_OP_RR:
+    case CExprOpCode::BINARY_OP_IR:
+    case CExprOpCode::BINARY_OP_RI:
+      os << "(" << CExpr::instance()->getOperatorName(instruction.op) << ")";
+      break;
+    case CExprOpCode::CALL:
+      os << "(";
+      functions_[instruction.arg1]->print(os, /*expanded*/false);
+      os << "," << instruction.arg2 << ")";
+      break;
+    case CExprOpCode::JUMP:
+    case CExprOpCode::JUMP_IF_FALSE:
+    case CExprOpCode::JUMP_IF_TRUE:
+    case CExprOpCode::STORE_TEMP:
+    case CExprOpCode::LOAD_TEMP:
+    case CExprOpCode::POWER_INT:
+      os << "(" << instruction.arg1 << ")";
+      break;
+    case CExprOpCode::BINARY_VAR_CONST:
+      os << "(" << identifiers_[instruction.arg1] << "," << *values_[instruction.arg2] << "," <<
+            opCodeName(instruction.fused) << "(" <<
+            CExpr::instance()->getOperatorName(instruction.op) << "))";
+      break;
+    case CExprOpCode::BINARY_VAR_VAR:
+      os << "(" << identifiers_[instruction.arg1] << "," << identifiers_[instruction.arg2] << "," <<
+            opCodeName(instruction.fused) << "(" <<
+            CExpr::instance()->getOperatorName(instruction.op) << "))";
+      break;
+    case CExprOpCode::BINARY_JUMP_IF_FALSE:
+    case CExprOpCode::BINARY_JUMP_IF_TRUE:
+      os << "(" << opCodeName(instruction.fused) << "(" <<
+            CExpr::instance()->getOperatorName(instruction.op) << ")," << instruction.arg1 << ")";
+      break;
+    default:
+      break;
+  }
+}
+
+const char *
+CExprProgram::
+opCodeName(CExprOpCode code)
+{
+  switch (code) {
+    case CExprOpCode::NOP              : return "nop";
+    case CExprOpCode::PUSH_VALUE       : return "push";
+    case CExprOpCode::PUSH_NULL        : return "push_null";
+    case CExprOpCode::LOAD_VAR         : return "load";
+    case CExprOpCode::STORE_VAR        : return "store";
+    case CExprOpCode::POP              : return "pop";
+    case CExprOpCode::UNARY_OP         : return "unary";
+    case CExprOpCode::LOGICAL_UNARY_OP : return "logical_unary";
+    case CExprOpCode::BITWISE_UNARY_OP : return "bitwise_unary";
+    case CExprOpCode::BINARY_OP        : return "binary";
+    case CExprOpCode::LOGICAL_BINARY_OP: return "logical_binary";
+    case CExprOpCode::BITWISE_BINARY_OP: return "bitwise_binary";
+    case CExprOpCode::CALL             : return "call";
+    case CExprOpCode::JUMP             : return "jump";
+    case CExprOpCode::JUMP_IF_FALSE    : return "jump_if_false";
+    case CExprOpCode::JUMP_IF_TRUE     : return "jump_if_true";
+    case CExprOpCode::UNARY_OP_I       : return "unary_i";
+    case CExprOpCode::UNARY_OP_R       : return "unary_r";
+    case CExprOpCode::BINARY_OP_II     : return "binary_ii";
+    case CExprOpCode::BINARY_OP_RR     : return "binary_rr";
+    case CExprOpCode::BINARY_OP_IR     : return "binary_ir";
+    case CExprOpCode::BINARY_OP_RI     : return "binary_ri";
+    case CExprOpCode::STORE_TEMP       : return "store_temp";
+    case CExprOpCode::LOAD_TEMP        : return "load_temp";
+    case CExprOpCode::BINARY_VAR_CONST : return "binary_var_const";
+    case CExprOpCode::BINARY_VAR_VAR   : return "binary_var_var";
+    case CExprOpCode::BINARY_JUMP_IF_FALSE: return "binary_jump_if_false";
+    case CExprOpCode::BINARY_JUMP_IF_TRUE : return "binary_jump_if_true";
+    case CExprOpCode::POWER_INT        : return "power_int";
+    case CExprOpCode::MOVE             : return "move";
+    default                            : return "?";
+  }
+}
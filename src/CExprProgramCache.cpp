@@ -0,0 +1,194 @@
+#include <CExprI.h>
+#include <iomanip>
+#include <sstream>
+
+void
+CExprProgramCache::
+setCapacity(uint maxEntries, size_t maxBytes)
+{
+  maxEntries_ = maxEntries;
+  maxBytes_   = maxBytes;
+
+  trim(maxEntries_, maxBytes_);
+}
+
+void
+CExprProgramCache::
+setNormalize(bool b)
+{
+  if (b == normalize_)
+    return;
+
+  // keys change
+  clear();
+
+  normalize_ = b;
+}
+
+CExprCompiledExprP
+CExprProgramCache::
+lookup(const std::string &str)
+{
+  // functions or constants changed since entries were compiled
+  if (generation_ != expr_->functionGeneration()) {
+    if (! entries_.empty()) {
+      clear();
+
+      ++stats_.invalidations;
+    }
+
+    generation_ = expr_->functionGeneration();
+  }
+
+  //---
+
+  CExprTokenStack pstack;
+  std::string     key;
+
+  if (normalize_) {
+    pstack = expr_->parseLine(str);
+    key    = tokenKey(pstack);
+  }
+  else
+    key = str;
+
+  auto p = entryMap_.find(key);
+
+  if (p != entryMap_.end()) {
+    ++stats_.hits;
+
+    // move to front
+    entries_.splice(entries_.begin(), entries_, (*p).second);
+
+    return entries_.front().compiledExpr;
+  }
+
+  ++stats_.misses;
+
+  //---
+
+  CExprCompiledExprP compiledExpr;
+
+  if (normalize_)
+    compiledExpr = std::make_shared<CExprCompiledExpr>(expr_, str, pstack);
+  else
+    compiledExpr = std::make_shared<CExprCompiledExpr>(expr_, str);
+
+  // invalid expressions are not cached so their errors are reported each time
+  if (! compiledExpr->isValid())
+    return CExprCompiledExprP();
+
+  Entry entry;
+
+  entry.key          = key;
+  entry.compiledExpr = compiledExpr;
+  entry.bytes        = entryBytes(entry);
+
+  // entry larger than max bytes is not cached
+  if (maxBytes_ > 0 && entry.bytes > maxBytes_)
+    return compiledExpr;
+
+  entries_.push_front(entry);
+
+  entryMap_[key] = entries_.begin();
+
+  ++stats_.numEntries;
+
+  stats_.numBytes += entry.bytes;
+
+  // remove least recently used entries to make room
+  trim(maxEntries_, maxBytes_);
+
+  return compiledExpr;
+}
+
+void
+CExprProgramCache::
+clear()
+{
+  entries_ .clear();
+  entryMap_.clear();
+
+  stats_.numEntries = 0;
+  stats_.numBytes   = 0;
+}
+
+void
+CExprProgramCache::
+resetStats()
+{
+  stats_.hits          = 0;
+  stats_.misses        = 0;
+  stats_.evictions     = 0;
+  stats_.invalidations = 0;
+}
+
+// remove least recently used entries until within limits (zero max bytes is no limit)
+void
+CExprProgramCache::
+trim(uint maxEntries, size_t maxBytes)
+{
+  while (! entries_.empty() &&
+         (stats_.numEntries > maxEntries || (maxBytes > 0 && stats_.numBytes > maxBytes))) {
+    const auto &entry = entries_.back();
+
+    entryMap_.erase(entry.key);
+
+    --stats_.numEntries;
+
+    stats_.numBytes -= entry.bytes;
+
+    entries_.pop_back();
+
+    ++stats_.evictions;
+  }
+}
+
+// token stream text with type of each token. Reals use full precision and strings
+// are prefixed by their length so different token streams have different keys
+std::string
+CExprProgramCache::
+tokenKey(const CExprTokenStack &pstack)
+{
+  std::ostringstream os;
+
+  os << std::setprecision(17);
+
+  for (uint i = 0; i < pstack.getNumTokens(); ++i) {
+    const auto &token = pstack.getToken(i);
+
+    if (token->type() == CExprTokenType::STRING) {
+      const auto &str = token->getString();
+
+      os << "<string>" << str.size() << ":" << str;
+    }
+    else
+      token->printQualified(os);
+
+    os << " ";
+  }
+
+  return os.str();
+}
+
+// estimated memory used by entry (key, map and list nodes, and program)
+size_t
+CExprProgramCache::
+entryBytes(const Entry &entry)
+{
+  const auto &compiledExpr = entry.compiledExpr;
+  const auto &program      = compiledExpr->program();
+
+  size_t bytes = sizeof(Entry) + sizeof(EntryMap::value_type) + sizeof(CExprCompiledExpr);
+
+  bytes += 2*entry.key.size() + compiledExpr->str().size();
+
+  bytes += program.numInstructions()*sizeof(CExprInstruction);
+  bytes += program.numValues()*(sizeof(CExprValuePtr) + sizeof(CExprValue));
+  bytes += program.numFunctions()*sizeof(CExprFunctionPtr);
+
+  for (uint i = 0; i < program.numIdentifiers(); ++i)
+    bytes += sizeof(std::string) + program.identifier(i).size();
+
+  return bytes;
+}
@@ -2,6 +2,7 @@
 #include <CMathGen.h>
 #include <NaN.h>
 #include <cerrno>
+#include <cmath>
 
 bool
 CExprRealValue::
@@ -24,6 +25,10 @@ execUnaryOp(CExpr *expr, CExprOpType op) const
       return expr->createRealValue(real_);
     case CExprOpType::UNARY_MINUS:
       return expr->createRealValue(-real_);
+    case CExprOpType::INCREMENT:
+      return expr->createRealValue(real_ + 1);
+    case CExprOpType::DECREMENT:
+      return expr->createRealValue(real_ - 1);
     default:
       return CExprValuePtr();
   }
@@ -31,7 +36,7 @@ execUnaryOp(CExpr *expr, CExprOpType op) const
 
 CExprValuePtr
 CExprRealValue::
-execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
+execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const
 {
   double rrhs;
 
@@ -86,7 +91,7 @@ execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
 
 double
 CExprRealValue::
-realPower(double real1, double real2, int *error_code) const
+realPower(double real1, double real2, int *error_code)
 {
   *error_code = 0;
 
@@ -124,6 +129,49 @@ realPower(double real1, double real2, int *error_code) const
   return real;
 }
 
+// constant integer power by repeated squaring (overflow and underflow are errors
+// as for pow)
+double
+CExprRealValue::
+realIntegerPower(double real1, long integer2, int *error_code)
+{
+  *error_code = 0;
+
+  if (IsNaN(real1)) {
+    *error_code = int(CExprErrorType::NAN_OPERATION);
+    return CMathGen::getNaN();
+  }
+
+  if (real1 == 0.0 && integer2 < 0) {
+    *error_code = int(CExprErrorType::ZERO_TO_NEG_POWER_UNDEF);
+    return CMathGen::getNaN();
+  }
+
+  long   n    = (integer2 < 0 ? -integer2 : integer2);
+  double real = 1.0;
+  double base = real1;
+
+  while (n > 0) {
+    if (n & 1)
+      real *= base;
+
+    n >>= 1;
+
+    if (n > 0)
+      base *= base;
+  }
+
+  if (integer2 < 0)
+    real = 1.0/real;
+
+  if (std::isfinite(real1) && real1 != 0.0 && (! std::isfinite(real) || real == 0.0)) {
+    *error_code = int(CExprErrorType::POWER_FAILED);
+    return CMathGen::getNaN();
+  }
+
+  return real;
+}
+
 double
 CExprRealValue::
 realModulus(double real1, double real2, int *error_code) const
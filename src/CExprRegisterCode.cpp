@@ -0,0 +1,413 @@
+#include <CExprI.h>
+#include <algorithm>
+
+bool
+CExprRegisterCode::
+build(const CExprProgram &program)
+{
+  using Type = CExprRegOperand::Type;
+
+  instructions_.clear();
+  results_     .clear();
+
+  numRegisters_ = 0;
+
+  const auto &instructions = program.instructions();
+
+  uint numInstructions = program.numInstructions();
+
+  Labels labels;
+
+  labels.isTarget.resize(numInstructions + 1, false);
+  labels.depth   .resize(numInstructions + 1, -1);
+  labels.regIndex.resize(numInstructions + 1, 0);
+
+  for (const auto &instruction : instructions) {
+    if (CExprProgram::isJump(instruction.code))
+      labels.isTarget[instruction.arg1] = true;
+  }
+
+  //---
+
+  // simulated operand stack (slot i is register i)
+  Operands stack;
+
+  for (uint pc = 0; pc < numInstructions; ++pc) {
+    const auto &instruction = instructions[pc];
+
+    if (! startInstruction(labels, stack, pc))
+      return false;
+
+    uint depth = uint(stack.size());
+
+    switch (instruction.code) {
+      case CExprOpCode::NOP:
+        break;
+      case CExprOpCode::PUSH_VALUE:
+        stack.push_back(CExprRegOperand(Type::CONST, instruction.arg1));
+        break;
+      case CExprOpCode::PUSH_NULL:
+        stack.push_back(CExprRegOperand(Type::NUL));
+        break;
+      case CExprOpCode::LOAD_VAR:
+        stack.push_back(CExprRegOperand(Type::VAR, instruction.arg1));
+        break;
+      case CExprOpCode::LOAD_TEMP:
+        // temporary is not changed after it is stored so can be read when used
+        stack.push_back(CExprRegOperand(Type::TEMP, instruction.arg1));
+        break;
+      case CExprOpCode::STORE_TEMP: {
+        if (depth < 1) return false;
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.lhs  = stack[depth - 1];
+        rinstruction.arg  = instruction.arg1;
+
+        addInstruction(rinstruction);
+
+        break;
+      }
+      case CExprOpCode::STORE_VAR: {
+        if (depth < 1) return false;
+
+        // pending reads of variable must see value before assignment
+        for (uint i = 0; i < depth - 1; ++i) {
+          if (stack[i].type == Type::VAR && stack[i].ind == instruction.arg1)
+            materialize(stack, i);
+        }
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.op   = instruction.op;
+        rinstruction.dst  = depth - 1;
+        rinstruction.lhs  = stack[depth - 1];
+        rinstruction.arg  = instruction.arg1;
+
+        addInstruction(rinstruction);
+
+        stack[depth - 1] = CExprRegOperand(Type::REG, depth - 1);
+
+        break;
+      }
+      case CExprOpCode::POP:
+        if (depth < 1) return false;
+
+        stack.pop_back();
+
+        break;
+      case CExprOpCode::UNARY_OP:
+      case CExprOpCode::LOGICAL_UNARY_OP:
+      case CExprOpCode::BITWISE_UNARY_OP:
+      case CExprOpCode::UNARY_OP_I:
+      case CExprOpCode::UNARY_OP_R:
+      case CExprOpCode::POWER_INT: {
+        if (depth < 1) return false;
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.op   = instruction.op;
+        rinstruction.dst  = depth - 1;
+        rinstruction.lhs  = stack[depth - 1];
+        rinstruction.arg  = instruction.arg1;
+
+        addInstruction(rinstruction);
+
+        stack[depth - 1] = CExprRegOperand(Type::REG, depth - 1);
+
+        break;
+      }
+      case CExprOpCode::BINARY_OP:
+      case CExprOpCode::LOGICAL_BINARY_OP:
+      case CExprOpCode::BITWISE_BINARY_OP:
+      case CExprOpCode::BINARY_OP_II:
+      case CExprOpCode::BINARY_OP_RR:
+      case CExprOpCode::BINARY_OP_IR:
+      case CExprOpCode::BINARY_OP_RI: {
+        if (depth < 2) return false;
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.op   = instruction.op;
+        rinstruction.dst  = depth - 2;
+        rinstruction.lhs  = stack[depth - 2];
+        rinstruction.rhs  = stack[depth - 1];
+
+        addInstruction(rinstruction);
+
+        stack.pop_back();
+
+        stack[depth - 2] = CExprRegOperand(Type::REG, depth - 2);
+
+        break;
+      }
+      case CExprOpCode::CALL: {
+        uint numArgs = instruction.arg2;
+
+        if (depth < numArgs) return false;
+
+        // function can change variables so read pending variables first
+        // and arguments must be in consecutive registers
+        for (uint i = 0; i < depth; ++i) {
+          if (stack[i].type == Type::VAR || (i >= depth - numArgs && stack[i].type != Type::REG))
+            materialize(stack, i);
+        }
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code    = instruction.code;
+        rinstruction.dst     = depth - numArgs;
+        rinstruction.arg     = instruction.arg1;
+        rinstruction.numArgs = numArgs;
+
+        addInstruction(rinstruction);
+
+        stack.resize(depth - numArgs);
+
+        stack.push_back(CExprRegOperand(Type::REG, depth - numArgs));
+
+        break;
+      }
+      case CExprOpCode::JUMP: {
+        materializeAll(stack, depth);
+
+        if (! setTargetDepth(labels, instruction.arg1, depth))
+          return false;
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.arg  = instruction.arg1;
+
+        addInstruction(rinstruction);
+
+        labels.reachable = false;
+
+        break;
+      }
+      case CExprOpCode::JUMP_IF_FALSE:
+      case CExprOpCode::JUMP_IF_TRUE: {
+        if (depth < 1) return false;
+
+        materializeAll(stack, depth - 1);
+
+        if (! setTargetDepth(labels, instruction.arg1, depth - 1))
+          return false;
+
+        CExprRegInstruction rinstruction;
+
+        rinstruction.code = instruction.code;
+        rinstruction.op   = instruction.op;
+        rinstruction.lhs  = stack[depth - 1];
+        rinstruction.arg  = instruction.arg1;
+
+        addInstruction(rinstruction);
+
+        stack.pop_back();
+
+        break;
+      }
+      default:
+        return false;
+    }
+
+    numRegisters_ = std::max(numRegisters_, uint(stack.size()));
+  }
+
+  if (! startInstruction(labels, stack, numInstructions))
+    return false;
+
+  // jump to register instruction index
+  for (auto &rinstruction : instructions_) {
+    if (CExprProgram::isJump(rinstruction.code))
+      rinstruction.arg = labels.regIndex[rinstruction.arg];
+  }
+
+  results_ = stack;
+
+  return true;
+}
+
+void
+CExprRegisterCode::
+addInstruction(const CExprRegInstruction &instruction)
+{
+  instructions_.push_back(instruction);
+}
+
+// copy stack operand into its register
+void
+CExprRegisterCode::
+materialize(Operands &stack, uint i)
+{
+  CExprRegInstruction rinstruction;
+
+  rinstruction.code = CExprOpCode::MOVE;
+  rinstruction.dst  = i;
+  rinstruction.lhs  = stack[i];
+
+  addInstruction(rinstruction);
+
+  stack[i] = CExprRegOperand(CExprRegOperand::Type::REG, i);
+}
+
+// start of instruction: values of all paths into jump target are in registers
+bool
+CExprRegisterCode::
+startInstruction(Labels &labels, Operands &stack, uint pc)
+{
+  if (labels.isTarget[pc]) {
+    if (labels.reachable) {
+      materializeAll(stack, uint(stack.size()));
+
+      if (labels.depth[pc] >= 0 && labels.depth[pc] != int(stack.size()))
+        return false;
+    }
+    else {
+      if (labels.depth[pc] < 0)
+        return false;
+
+      stack.clear();
+
+      for (int i = 0; i < labels.depth[pc]; ++i)
+        stack.push_back(CExprRegOperand(CExprRegOperand::Type::REG, uint(i)));
+
+      labels.reachable = true;
+    }
+  }
+  else if (! labels.reachable)
+    return false;
+
+  labels.regIndex[pc] = uint(instructions_.size());
+
+  return true;
+}
+
+bool
+CExprRegisterCode::
+setTargetDepth(Labels &labels, uint target, uint depth)
+{
+  if (labels.depth[target] >= 0 && labels.depth[target] != int(depth))
+    return false;
+
+  labels.depth[target] = int(depth);
+
+  return true;
+}
+
+// copy first n stack operands into their registers
+void
+CExprRegisterCode::
+materializeAll(Operands &stack, uint n)
+{
+  for (uint i = 0; i < n; ++i) {
+    if (stack[i].type != CExprRegOperand::Type::REG)
+      materialize(stack, i);
+  }
+}
+
+void
+CExprRegisterCode::
+print(std::ostream &os, const CExprProgram &program) const
+{
+  for (const auto &instruction : instructions_) {
+    os << " " << CExprProgram::opCodeName(instruction.code) << "(";
+
+    if (! CExprProgram::isJump(instruction.code) && instruction.code != CExprOpCode::STORE_TEMP)
+      os << "r" << instruction.dst << ",";
+
+    switch (instruction.code) {
+      case CExprOpCode::MOVE:
+      case CExprOpCode::UNARY_OP:
+      case CExprOpCode::LOGICAL_UNARY_OP:
+      case CExprOpCode::BITWISE_UNARY_OP:
+      case CExprOpCode::UNARY_OP_I:
+      case CExprOpCode::UNARY_OP_R:
+        if (instruction.op != CExprOpType::UNKNOWN)
+          os << CExpr::instance()->getOperatorName(instruction.op) << ",";
+
+        printOperand(os, program, instruction.lhs);
+
+        break;
+      case CExprOpCode::POWER_INT:
+        printOperand(os, program, instruction.lhs);
+
+        os << "," << instruction.arg;
+
+        break;
+      case CExprOpCode::BINARY_OP:
+      case CExprOpCode::LOGICAL_BINARY_OP:
+      case CExprOpCode::BITWISE_BINARY_OP:
+      case CExprOpCode::BINARY_OP_II:
+      case CExprOpCode::BINARY_OP_RR:
+      case CExprOpCode::BINARY_OP_IR:
+      case CExprOpCode::BINARY_OP_RI:
+        printOperand(os, program, instruction.lhs);
+
+        os << CExpr::instance()->getOperatorName(instruction.op);
+
+        printOperand(os, program, instruction.rhs);
+
+        break;
+      case CExprOpCode::STORE_VAR:
+        os << program.identifier(instruction.arg) << ",";
+
+        printOperand(os, program, instruction.lhs);
+
+        break;
+      case CExprOpCode::STORE_TEMP:
+        os << "t" << instruction.arg << ",";
+
+        printOperand(os, program, instruction.lhs);
+
+        break;
+      case CExprOpCode::CALL:
+        program.function(instruction.arg)->print(os, /*expanded*/false);
+
+        os << "," << instruction.numArgs;
+
+        break;
+      case CExprOpCode::JUMP:
+        os << instruction.arg;
+
+        break;
+      case CExprOpCode::JUMP_IF_FALSE:
+      case CExprOpCode::JUMP_IF_TRUE:
+        printOperand(os, program, instruction.lhs);
+
+        os << "," << instruction.arg;
+
+        break;
+      default:
+        break;
+    }
+
+    os << ")";
+  }
+
+  os << " ->";
+
+  for (const auto &operand : results_) {
+    os << " ";
+
+    printOperand(os, program, operand);
+  }
+}
+
+void
+CExprRegisterCode::
+printOperand(std::ostream &os, const CExprProgram &program, const CExprRegOperand &operand)
+{
+  switch (operand.type) {
+    case CExprRegOperand::Type::REG  : os << "r" << operand.ind; break;
+    case CExprRegOperand::Type::CONST: os << *program.value(operand.ind); break;
+    case CExprRegOperand::Type::VAR  : os << program.identifier(operand.ind); break;
+    case CExprRegOperand::Type::TEMP : os << "t" << operand.ind; break;
+    case CExprRegOperand::Type::NUL  : os << "<null>"; break;
+    default                          : os << "?"; break;
+  }
+}
@@ -30,7 +30,7 @@ execUnaryOp(CExpr *, CExprOpType) const
 
 CExprValuePtr
 CExprStringValue::
-execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
+execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const
 {
   std::string rstr;
 
@@ -63,15 +63,6 @@ getValue() const
   return static_cast<const CExprTokenValue *>(this)->getValue();
 }
 
-const CExprTokenStack &
-CExprTokenBase::
-getBlock() const
-{
-  assert(type() == CExprTokenType::BLOCK);
-
-  return static_cast<const CExprTokenBlock *>(this)->stack();
-}
-
 void
 CExprTokenBase::
 printQualified(std::ostream &os) const
@@ -84,7 +75,6 @@ printQualified(std::ostream &os) const
     case CExprTokenType::STRING    : os << "<string>"; break;
     case CExprTokenType::FUNCTION  : os << "<function>"; break;
     case CExprTokenType::VALUE     : os << "<value>"; break;
-    case CExprTokenType::BLOCK     : os << "<block>"; break;
     default                        : os << "<-?->"; break;
   }
 
@@ -1,5 +1,4 @@
-#include <CExprTokenStack.h>
-#include <CExprFunction.h>
+#include <CExprI.h>
 
 bool
 CExprTokenStack::
@@ -2,51 +2,85 @@
 
 CExprValue::
 CExprValue() :
- type_(CExprValueType::NONE)
+ type_(CExprValueType::NONE), integer_(0)
 {
 }
 
 CExprValue::
 CExprValue(const CExprBooleanValue &boolean) :
- type_(CExprValueType::BOOLEAN), base_(boolean.dup())
+ type_(CExprValueType::BOOLEAN)
 {
+  boolean.getBooleanValue(boolean_);
 }
 
 CExprValue::
 CExprValue(const CExprIntegerValue &integer) :
- type_(CExprValueType::INTEGER), base_(integer.dup())
+ type_(CExprValueType::INTEGER)
 {
+  integer.getIntegerValue(integer_);
 }
 
 CExprValue::
 CExprValue(const CExprRealValue &real) :
- type_(CExprValueType::REAL), base_(real.dup())
+ type_(CExprValueType::REAL)
 {
+  real.getRealValue(real_);
 }
 
 CExprValue::
 CExprValue(const CExprStringValue &str) :
- type_(CExprValueType::STRING), base_(str.dup())
+ type_(CExprValueType::STRING)
 {
+  new (&str_) std::string;
+
+  str.getStringValue(str_);
+}
+
+CExprValue::
+CExprValue(const CExprValue &value) :
+ CExprRefCounted(), type_(CExprValueType::NONE), integer_(0)
+{
+  *this = value;
 }
 
 CExprValue::
 ~CExprValue()
 {
+  if (type_ == CExprValueType::STRING)
+    str_.~basic_string();
+}
+
+CExprValue &
+CExprValue::
+operator=(const CExprValue &value)
+{
+  // shared constant value is never changed
+  if (&value == this || ! setType(value.type_))
+    return *this;
+
+  switch (type_) {
+    case CExprValueType::BOOLEAN: boolean_ = value.boolean_; break;
+    case CExprValueType::INTEGER: integer_ = value.integer_; break;
+    case CExprValueType::REAL   : real_    = value.real_   ; break;
+    case CExprValueType::STRING : str_     = value.str_    ; break;
+    default                     :                            break;
+  }
+
+  return *this;
 }
 
 CExprValue *
 CExprValue::
 dup() const
 {
-  auto *value1 = new CExprValue;
+  if (! pool_)
+    return new CExprValue(*this);
 
-  value1->type_ = type_;
+  auto *value = pool_->alloc();
 
-  if (base_)
-    value1->base_ = CExprValueBaseP(base_->dup());
+  *value = *this;
 
-  return value1;
+  return value;
 }
 
 bool
@@ -81,64 +115,100 @@ bool
 CExprValue::
 getBooleanValue(bool &b) const
 {
-  return base_->getBooleanValue(b);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: return CExprBooleanValue(boolean_).getBooleanValue(b);
+    case CExprValueType::INTEGER: return CExprIntegerValue(integer_).getBooleanValue(b);
+    case CExprValueType::REAL   : return CExprRealValue   (real_   ).getBooleanValue(b);
+    case CExprValueType::STRING : return CExprStringValue (str_    ).getBooleanValue(b);
+    default                     : return false;
+  }
 }
 
 bool
 CExprValue::
 getIntegerValue(long &l) const
 {
-  return base_->getIntegerValue(l);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: return CExprBooleanValue(boolean_).getIntegerValue(l);
+    case CExprValueType::INTEGER: return CExprIntegerValue(integer_).getIntegerValue(l);
+    case CExprValueType::REAL   : return CExprRealValue   (real_   ).getIntegerValue(l);
+    case CExprValueType::STRING : return CExprStringValue (str_    ).getIntegerValue(l);
+    default                     : return false;
+  }
 }
 
 bool
 CExprValue::
 getRealValue(double &r) const
 {
-  return base_->getRealValue(r);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: return CExprBooleanValue(boolean_).getRealValue(r);
+    case CExprValueType::INTEGER: return CExprIntegerValue(integer_).getRealValue(r);
+    case CExprValueType::REAL   : return CExprRealValue   (real_   ).getRealValue(r);
+    case CExprValueType::STRING : return CExprStringValue (str_    ).getRealValue(r);
+    default                     : return false;
+  }
 }
 
 bool
 CExprValue::
 getStringValue(std::string &s) const
 {
-  return base_->getStringValue(s);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: return CExprBooleanValue(boolean_).getStringValue(s);
+    case CExprValueType::INTEGER: return CExprIntegerValue(integer_).getStringValue(s);
+    case CExprValueType::REAL   : return CExprRealValue   (real_   ).getStringValue(s);
+    case CExprValueType::STRING : s = str_; return true;
+    default                     : return false;
+  }
 }
 
-void
+bool
 CExprValue::
 setBooleanValue(bool b)
 {
-  assert(isBooleanValue());
+  if (! isBooleanValue() || isConstant())
+    return false;
+
+  boolean_ = b;
 
-  base_->setBooleanValue(b);
+  return true;
 }
 
-void
+bool
 CExprValue::
 setIntegerValue(long l)
 {
-  assert(isIntegerValue());
+  if (! isIntegerValue() || isConstant())
+    return false;
+
+  integer_ = l;
 
-  base_->setIntegerValue(l);
+  return true;
 }
 
-void
+bool
 CExprValue::
 setRealValue(double r)
 {
-  assert(isRealValue());
+  if (! isRealValue() || isConstant())
+    return false;
+
+  real_ = r;
 
-  base_->setRealValue(r);
+  return true;
 }
 
-void
+bool
 CExprValue::
 setStringValue(const std::string &s)
 {
-  assert(isStringValue());
+  if (! isStringValue() || isConstant())
+    return false;
+
+  str_ = s;
 
-  base_->setStringValue(s);
+  return true;
 }
 
 bool
@@ -173,8 +243,10 @@ convToBoolean()
   if (! getBooleanValue(boolean))
     return false;
 
-  type_ = CExprValueType::BOOLEAN;
-  base_ = CExprValueBaseP(new CExprBooleanValue(boolean));
+  if (! setType(CExprValueType::BOOLEAN))
+    return false;
+
+  boolean_ = boolean;
 
   return true;
 }
@@ -190,8 +262,10 @@ convToInteger()
   if (! getIntegerValue(integer))
     return false;
 
-  type_ = CExprValueType::INTEGER;
-  base_ = CExprValueBaseP(new CExprIntegerValue(integer));
+  if (! setType(CExprValueType::INTEGER))
+    return false;
+
+  integer_ = integer;
 
   return true;
 }
@@ -207,8 +281,10 @@ convToReal()
   if (! getRealValue(real))
     return false;
 
-  type_ = CExprValueType::REAL;
-  base_ = CExprValueBaseP(new CExprRealValue(real));
+  if (! setType(CExprValueType::REAL))
+    return false;
+
+  real_ = real;
 
   return true;
 }
@@ -224,8 +300,10 @@ convToString()
   if (! getStringValue(str))
     return false;
 
-  type_ = CExprValueType::STRING;
-  base_ = CExprValueBaseP(new CExprStringValue(str));
+  if (! setType(CExprValueType::STRING))
+    return false;
+
+  str_ = str;
 
   return true;
 }
@@ -234,19 +312,78 @@ CExprValuePtr
 CExprValue::
 execUnaryOp(CExpr *expr, CExprOpType op) const
 {
-  return base_->execUnaryOp(expr, op);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: return CExprBooleanValue(boolean_).execUnaryOp(expr, op);
+    case CExprValueType::INTEGER: return CExprIntegerValue(integer_).execUnaryOp(expr, op);
+    case CExprValueType::REAL   : return CExprRealValue   (real_   ).execUnaryOp(expr, op);
+    case CExprValueType::STRING : return CExprStringValue (str_    ).execUnaryOp(expr, op);
+    default                     : return CExprValuePtr();
+  }
 }
 
 CExprValuePtr
 CExprValue::
-execBinaryOp(CExpr *expr, CExprValuePtr rhs, CExprOpType op) const
+execBinaryOp(CExpr *expr, const CExprValuePtr &rhs, CExprOpType op) const
 {
-  return base_->execBinaryOp(expr, rhs, op);
+  switch (type_) {
+    case CExprValueType::BOOLEAN:
+      return CExprBooleanValue(boolean_).execBinaryOp(expr, rhs, op);
+    case CExprValueType::INTEGER:
+      return CExprIntegerValue(integer_).execBinaryOp(expr, rhs, op);
+    case CExprValueType::REAL:
+      return CExprRealValue(real_).execBinaryOp(expr, rhs, op);
+    case CExprValueType::STRING:
+      return CExprStringValue(str_).execBinaryOp(expr, rhs, op);
+    default:
+      return CExprValuePtr();
+  }
 }
 
 void
 CExprValue::
 print(std::ostream &os) const
 {
-  base_->print(os);
+  switch (type_) {
+    case CExprValueType::BOOLEAN: CExprBooleanValue(boolean_).print(os); break;
+    case CExprValueType::INTEGER: CExprIntegerValue(integer_).print(os); break;
+    case CExprValueType::REAL   : CExprRealValue   (real_   ).print(os); break;
+    case CExprValueType::STRING : os << str_; break;
+    default                     : os << "<null>"; break;
+  }
+}
+
+bool
+CExprValue::
+setType(CExprValueType type)
+{
+  // shared constant value must be copied before it is changed
+  if (isConstant())
+    return false;
+
+  if (type == type_)
+    return true;
+
+  // only string data needs explicit construction/destruction
+  if (type_ == CExprValueType::STRING)
+    str_.~basic_string();
+
+  type_ = type;
+
+  if (type_ == CExprValueType::STRING)
+    new (&str_) std::string;
+
+  return true;
+}
+
+//------
+
+void
+CExprRefPtrDestroy(CExprValue *value)
+{
+  auto *pool = value->pool();
+
+  if (pool)
+    pool->release(value);
+  else
+    delete value;
 }
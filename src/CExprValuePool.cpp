@@ -0,0 +1,111 @@
+#include <CExprI.h>
+
+CExprValuePool::
+CExprValuePool()
+{
+}
+
+CExprValuePool::
+~CExprValuePool()
+{
+  trimFree(0);
+}
+
+void
+CExprValuePool::
+setMaxFree(uint n)
+{
+  maxFree_ = n;
+
+  trimFree(maxFree_);
+}
+
+void
+CExprValuePool::
+resetStats()
+{
+  stats_.hits      = 0;
+  stats_.misses    = 0;
+  stats_.highWater = stats_.inUse;
+}
+
+CExprValue *
+CExprValuePool::
+alloc()
+{
+  assert(! detached_);
+
+  CExprValue *value;
+
+  if (! free_.empty()) {
+    value = free_.back();
+
+    free_.pop_back();
+
+    ++stats_.hits;
+  }
+  else {
+    value = new CExprValue;
+
+    value->pool_ = this;
+
+    ++stats_.misses;
+  }
+
+  ++stats_.inUse;
+
+  if (stats_.inUse > stats_.highWater)
+    stats_.highWater = stats_.inUse;
+
+  stats_.numFree = uint(free_.size());
+
+  return value;
+}
+
+void
+CExprValuePool::
+release(CExprValue *value)
+{
+  assert(value->pool_ == this && stats_.inUse > 0);
+
+  --stats_.inUse;
+
+  if (! detached_ && free_.size() < maxFree_) {
+    // drop any string data before reuse
+    value->setType(CExprValueType::NONE);
+
+    free_.push_back(value);
+  }
+  else
+    delete value;
+
+  stats_.numFree = uint(free_.size());
+
+  if (detached_ && stats_.inUse == 0)
+    delete this;
+}
+
+void
+CExprValuePool::
+detach()
+{
+  detached_ = true;
+
+  trimFree(0);
+
+  if (stats_.inUse == 0)
+    delete this;
+}
+
+void
+CExprValuePool::
+trimFree(uint n)
+{
+  while (free_.size() > n) {
+    delete free_.back();
+
+    free_.pop_back();
+  }
+
+  stats_.numFree = uint(free_.size());
+}
@@ -13,7 +13,7 @@ createVariable(const std::string &name, CExprValuePtr value)
   auto variable = getVariable(name);
 
   if (! variable) {
-    variable = std::make_shared<CExprVariable>(name, value);
+    variable = CExprVariablePtr(new CExprVariable(name, value));
 
     addVariable(variable);
   }
@@ -30,7 +30,7 @@ createUserVariable(const std::string &name, CExprVariableObj *obj)
   auto variable = getVariable(name);
 
   if (! variable) {
-    variable = std::make_shared<CExprVariable>(name, CExprValuePtr());
+    variable = CExprVariablePtr(new CExprVariable(name, CExprValuePtr()));
 
     addVariable(variable);
   }
@@ -44,33 +44,143 @@ CExprVariablePtr
 CExprVariableMgr::
 getVariable(const std::string &name) const
 {
-  for (const auto &var : variables_)
-    if (var->name() == name)
-      return var;
+  int i = findSlot(name, nameHash(name));
 
-  return CExprVariablePtr();
+  if (i < 0)
+    return CExprVariablePtr();
+
+  return variables_[slots_[i].ind - 1];
 }
 
+// index of slot for variable name (-1 if not found)
+int
+CExprVariableMgr::
+findSlot(const std::string &name, size_t hash) const
+{
+  if (slots_.empty())
+    return -1;
+
+  uint mask = uint(slots_.size() - 1);
+
+  // table is never full so probe ends at empty slot
+  for (uint i = uint(hash) & mask; ; i = (i + 1) & mask) {
+    const auto &slot = slots_[i];
+
+    if (slot.ind == 0)
+      return -1;
+
+    if (slot.ind != removedInd && slot.hash == hash &&
+        variables_[slot.ind - 1]->name() == name)
+      return int(i);
+  }
+}
+
+// variable must not already exist
 void
 CExprVariableMgr::
 addVariable(CExprVariablePtr variable)
 {
+  // keep at most half of slots used and compact removed variables
+  if (2*(numUsedSlots_ + 1) > slots_.size() || variables_.size() > 2*numVariables_ + 16)
+    rehash();
+
   variables_.push_back(variable);
+
+  ++numVariables_;
+
+  size_t hash = nameHash(variable->name());
+
+  uint mask = uint(slots_.size() - 1);
+
+  uint i = uint(hash) & mask;
+
+  while (slots_[i].ind != 0 && slots_[i].ind != removedInd)
+    i = (i + 1) & mask;
+
+  if (slots_[i].ind == 0)
+    ++numUsedSlots_;
+
+  slots_[i].hash = hash;
+  slots_[i].ind  = uint(variables_.size());
 }
 
 void
 CExprVariableMgr::
 removeVariable(CExprVariablePtr variable)
 {
-  variables_.remove(variable);
+  if (! variable)
+    return;
+
+  int i = findSlot(variable->name(), nameHash(variable->name()));
+
+  if (i < 0 || variables_[slots_[i].ind - 1] != variable)
+    return;
+
+  variable->setRemoved(true);
+
+  variables_[slots_[i].ind - 1] = CExprVariablePtr();
+
+  slots_[i].ind = removedInd;
+
+  --numVariables_;
+}
+
+// remove removed variables and rebuild hash table for current variables
+void
+CExprVariableMgr::
+rehash()
+{
+  Variables variables;
+
+  variables.reserve(numVariables_ + 1);
+
+  for (const auto &variable : variables_) {
+    if (variable)
+      variables.push_back(variable);
+  }
+
+  variables_.swap(variables);
+
+  uint numSlots = 16;
+
+  while (numSlots < 4*(numVariables_ + 1))
+    numSlots *= 2;
+
+  slots_.clear();
+  slots_.resize(numSlots);
+
+  uint mask = numSlots - 1;
+
+  for (uint ind = 0; ind < variables_.size(); ++ind) {
+    size_t hash = nameHash(variables_[ind]->name());
+
+    uint i = uint(hash) & mask;
+
+    while (slots_[i].ind != 0)
+      i = (i + 1) & mask;
+
+    slots_[i].hash = hash;
+    slots_[i].ind  = ind + 1;
+  }
+
+  numUsedSlots_ = numVariables_;
+}
+
+size_t
+CExprVariableMgr::
+nameHash(const std::string &name)
+{
+  return std::hash<std::string>()(name);
 }
 
 void
 CExprVariableMgr::
 getVariableNames(std::vector<std::string> &names) const
 {
-  for (const auto &var : variables_)
-    names.push_back(var->name());
+  for (const auto &variable : variables_) {
+    if (variable)
+      names.push_back(variable->name());
+  }
 }
 
 //------
@@ -92,38 +202,188 @@ getValue() const
 {
   if (obj_)
     return obj_->get();
-  else
-    return value_;
+
+  if (bind_.data)
+    updateBoundValue();
+
+  return value_;
 }
 
-void
+bool
 CExprVariable::
 setValue(const CExprValuePtr &value)
 {
-  if (obj_)
+  if (obj_) {
     obj_->set(value);
-  else
+
+    return true;
+  }
+
+  if (! bind_.data) {
     value_ = value;
+
+    return true;
+  }
+
+  if (! value)
+    return false;
+
+  switch (bind_.type) {
+    case CExprValueType::REAL: {
+      double r;
+
+      if (! value->getRealValue(r))
+        return false;
+
+      *static_cast<double *>(bind_.data) = r;
+
+      break;
+    }
+    case CExprValueType::INTEGER: {
+      long l;
+
+      if (! value->getIntegerValue(l))
+        return false;
+
+      *static_cast<long *>(bind_.data) = l;
+
+      break;
+    }
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+void
+CExprVariable::
+bind(CExpr *expr, CExprValueType type, void *data)
+{
+  bind_.expr = expr;
+  bind_.type = type;
+  bind_.data = data;
+
+  if (bind_.data)
+    value_ = CExprValuePtr();
+}
+
+void
+CExprVariable::
+shadow(const CExprValuePtr &value, Shadow &shadow)
+{
+  shadow.value = value_;
+  shadow.obj   = obj_;
+  shadow.bind  = bind_;
+
+  value_ = value;
+  obj_   = nullptr;
+  bind_  = Bind();
+}
+
+void
+CExprVariable::
+unshadow(const Shadow &shadow)
+{
+  value_ = shadow.value;
+  obj_   = shadow.obj;
+  bind_  = shadow.bind;
+}
+
+// make value match bound memory. The last value is returned if memory is unchanged
+// and is updated in place if not shared, so reads don't normally allocate values
+void
+CExprVariable::
+updateBoundValue() const
+{
+  switch (bind_.type) {
+    case CExprValueType::REAL: {
+      double r = *static_cast<const double *>(bind_.data);
+
+      if (value_ && value_->isRealValue()) {
+        if (value_->real() == r)
+          return;
+
+        if (isValueOwner() && value_->setRealValue(r))
+          return;
+      }
+
+      value_ = bind_.expr->createRealValue(r);
+
+      break;
+    }
+    case CExprValueType::INTEGER: {
+      long l = *static_cast<const long *>(bind_.data);
+
+      if (value_ && value_->isIntegerValue()) {
+        if (value_->integer() == l)
+          return;
+
+        if (isValueOwner() && value_->setIntegerValue(l))
+          return;
+      }
+
+      value_ = bind_.expr->createIntegerValue(l);
+
+      break;
+    }
+    case CExprValueType::STRING: {
+      const char *s = static_cast<const char *>(bind_.data);
+
+      if (value_ && value_->isStringValue()) {
+        if (value_->string() == s)
+          return;
+
+        if (isValueOwner() && value_->setStringValue(s))
+          return;
+      }
+
+      value_ = bind_.expr->createStringValue(s);
+
+      break;
+    }
+    default:
+      break;
+  }
 }
 
 void
 CExprVariable::
 setRealValue(CExpr *expr, double r)
 {
-  if (! obj_ && value_->isRealValue())
-    value_->setRealValue(r);
-  else
-    setValue(expr->createRealValue(r));
+  if (bind_.data) {
+    (void) setValue(expr->createRealValue(r));
+    return;
+  }
+
+  // update in place only if value not shared (copy on write)
+  if (! obj_ && value_ && isValueOwner() && value_->setRealValue(r))
+    return;
+
+  setValue(expr->createRealValue(r));
 }
 
 void
 CExprVariable::
 setIntegerValue(CExpr *expr, long i)
 {
-  if (! obj_ && value_->isIntegerValue())
-    value_->setIntegerValue(i);
-  else
-    setValue(expr->createIntegerValue(i));
+  if (bind_.data) {
+    (void) setValue(expr->createIntegerValue(i));
+    return;
+  }
+
+  // update in place only if value not shared (copy on write)
+  if (! obj_ && value_ && isValueOwner() && value_->setIntegerValue(i))
+    return;
+
+  setValue(expr->createIntegerValue(i));
+}
+
+bool
+CExprVariable::
+isValueOwner() const
+{
+  return (value_.isUnique() && ! value_->isConstant());
 }
 
 CExprValueType
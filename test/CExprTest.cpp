@@ -3,6 +3,7 @@
 #include <CExpr.h>
 #include <CReadLine.h>
 #include <CParseLine.h>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
@@ -16,6 +17,10 @@ static int function = FUNCTION_EXECUTE;
 static void processFile(const std::string &filename);
 static void mainLoop();
 static bool processLine(const std::string &line);
+static std::string parseIdentifier(CParseLine &parse);
+
+static double      hypotenuse(double a, double b);
+static std::string repeat(const std::string &str, long n);
 
 CExpr *expr;
 
@@ -24,7 +29,10 @@ CExpr *expr;
 extern int
 main(int argc, char **argv)
 {
-  bool debug = false;
+  bool debug    = false;
+  bool register_ = false;
+  bool fusions  = false;
+  bool cache    = false;
 
   std::vector<std::string> files;
 
@@ -40,6 +48,12 @@ main(int argc, char **argv)
         function = FUNCTION_PARSE;
       else if (argv[i][1] == 'd')
         debug = true;
+      else if (argv[i][1] == 'r')
+        register_ = true;
+      else if (argv[i][1] == 'f')
+        fusions = true;
+      else if (argv[i][1] == 'k')
+        cache = true;
     }
     else
       files.push_back(argv[i]);
@@ -48,6 +62,15 @@ main(int argc, char **argv)
   expr = new CExpr;
 
   expr->setDebug(debug);
+  expr->setRegisterVM(register_);
+
+  // variable assignments are evaluated through program cache
+  if (cache)
+    expr->setProgramCacheCapacity(256);
+
+  // typed native functions
+  expr->addFunction<double(double, double)>("hypot", hypotenuse);
+  expr->addFunction<std::string(const std::string &, long)>("repeat", repeat);
 
   uint num_files = files.size();
 
@@ -58,6 +81,9 @@ main(int argc, char **argv)
   else
     mainLoop();
 
+  if (fusions)
+    expr->printFusionCounts(std::cerr);
+
   exit(0);
 }
 
@@ -113,24 +139,20 @@ processLine(const std::string &line)
 
   parse.skipSpace();
 
-  std::string identifier;
+  std::string identifier = parseIdentifier(parse);
 
-  while (parse.isValid()) {
-    char c = parse.lookChar();
+  parse.skipSpace();
 
-    if (identifier.empty()) {
-      if (! isalpha(c))
-        break;
-    }
-    else {
-      if (! isalnum(c) && c != '_')
-        break;
-    }
+  // constant definition
+  bool constant = false;
 
-    identifier += parse.getChar();
-  }
+  if (identifier == "const" && ! parse.isChar('=') && ! parse.isChar('(')) {
+    identifier = parseIdentifier(parse);
 
-  parse.skipSpace();
+    parse.skipSpace();
+
+    constant = true;
+  }
 
   // variable assignment
   if      (identifier != "" && parse.isChar('=')) {
@@ -146,7 +168,10 @@ processLine(const std::string &line)
     if (! value.isValid())
       return false;
 
-    expr->createVariable(identifier, value);
+    if (constant)
+      expr->createConstant(identifier, value);
+    else
+      expr->createVariable(identifier, value);
 
     return true;
   }
@@ -201,13 +226,17 @@ processLine(const std::string &line)
     CExprITokenPtr itoken = expr->interpPTokenStack(pstack);
 
     if (function != FUNCTION_INTERP) {
-      CExprTokenStack cstack = expr->compileIToken(itoken);
+      CExprProgram program = expr->compileIToken(itoken);
 
       if (function != FUNCTION_COMPILE) {
         CExprValuePtr value;
 
-        if (expr->executeCTokenStack(cstack, value))
-          std::cerr << line << " = " << value << std::endl;
+        if (expr->executeProgram(program, value)) {
+          if (value.isValid())
+            std::cerr << line << " = " << *value << std::endl;
+          else
+            std::cerr << line << " = <null>" << std::endl;
+        }
         else
           std::cerr << "Error: " << line << std::endl;
       }
@@ -216,3 +245,43 @@ processLine(const std::string &line)
 
   return true;
 }
+
+static std::string
+parseIdentifier(CParseLine &parse)
+{
+  std::string identifier;
+
+  while (parse.isValid()) {
+    char c = parse.lookChar();
+
+    if (identifier.empty()) {
+      if (! isalpha(c))
+        break;
+    }
+    else {
+      if (! isalnum(c) && c != '_')
+        break;
+    }
+
+    identifier += parse.getChar();
+  }
+
+  return identifier;
+}
+
+static double
+hypotenuse(double a, double b)
+{
+  return std::sqrt(a*a + b*b);
+}
+
+static std::string
+repeat(const std::string &str, long n)
+{
+  std::string str1;
+
+  for (long i = 0; i < n; ++i)
+    str1 += str;
+
+  return str1;
+}